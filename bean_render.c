@@ -0,0 +1,682 @@
+#include "bean_render.h"
+#include "raylib/raymath.h"
+#include "raylib/rlgl.h"
+#include "stereo.h"
+#include "cull.h"
+#include "trace.h"
+#include <GLES3/gl3.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// capsule tessellation per level of detail, the first one is what DrawCapsule was called with
+// rings has to be even, half of them go to each hemisphere
+#define BEAN_MESH_LODS 3
+static const int lodRings[BEAN_MESH_LODS] = { 8, 4, 2 };
+static const int lodSlices[BEAN_MESH_LODS] = { 8, 6, 4 };
+
+// the last level is a flat capsule shape that always turns to face the camera
+#define BEAN_LODS (BEAN_MESH_LODS + 1)
+#define BEAN_IMPOSTOR_LOD BEAN_MESH_LODS
+#define BEAN_IMPOSTOR_SEGMENTS 4 // per half circle
+
+// hands are a small ball, same tessellation DrawSphereEx had for them
+#define HAND_RINGS 6
+#define HAND_SLICES 6
+
+// size on screen (bounding radius over distance, scaled by the projection) below which each level kicks in
+static const float lodSizes[BEAN_LODS - 1] = { 0.25f, 0.1f, 0.03f };
+// how far past a threshold a bean has to go before it switches, stops beans sitting on the edge from flickering
+#define BEAN_LOD_BAND 0.15f
+// outlines are a whole second pass of lines, not worth it once a bean is a few pixels wide
+#define BEAN_OUTLINE_DISTANCE 25.0f
+
+// room for every level, the biggest one sets the size
+#define BEAN_MAX_VERTICES 512
+#define BEAN_MAX_INDICES 2048
+
+typedef struct BeanLod {
+    int triangleFirst;
+    int triangleCount;
+    int lineFirst;
+    int lineCount;
+} BeanLod;
+
+// per instance data, laid out exactly how the vertex shader reads it
+typedef struct BeanInstance {
+    float transform[16]; // column major, same order as MatrixToFloatV
+    unsigned char color[4];
+} BeanInstance;
+
+// the stereo prelude from stereo.c goes in front of these
+static const char* beanVertexShader =
+    "layout(location = 0) in vec3 vertexPosition;\n"
+    "layout(location = 1) in mat4 instanceTransform;\n" // takes locations 1 to 4
+    "layout(location = 5) in vec4 instanceColor;\n"
+    "uniform float outline;\n"
+    "uniform float billboard;\n"
+    "uniform vec3 billboardRight;\n"
+    "out vec4 fragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    fragColor = mix(instanceColor, vec4(0.0, 0.0, 0.0, 1.0), outline);\n"
+    "    vec4 world = instanceTransform*vec4(vertexPosition, 1.0);\n"
+    "    if (billboard > 0.5) world = vec4(instanceTransform[3].xyz + billboardRight*vertexPosition.x + vec3(0.0, vertexPosition.y, 0.0), 1.0);\n"
+    "    gl_Position = StereoPosition(world);\n"
+    "}\n";
+
+static const char* beanFragmentShader =
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    StereoClip();\n"
+    "    finalColor = fragColor;\n"
+    "}\n";
+
+static bool instanced = false;
+static StereoShader shader = { 0 };
+static int outlineLoc = -1;
+static int billboardLoc = -1;
+static int billboardRightLoc = -1;
+
+static GLuint vao = 0;
+static GLuint vertexBuffer = 0;
+static GLuint indexBuffer = 0;
+static GLuint instanceBuffer = 0;
+static int instanceBufferCapacity = 0;
+
+// every level lives in the same buffers, the mesh is kept on the cpu too for the batched fallback
+static Vector3 vertices[BEAN_MAX_VERTICES];
+static unsigned short indices[BEAN_MAX_INDICES];
+static int vertexCount = 0;
+static int indexCount = 0;
+static BeanLod lods[BEAN_LODS];
+static BeanLod handMesh;
+
+static float lodBias = 1.0f;
+
+// beans queued this frame, split up by component so culling can chew through them 4 at a time
+static float* beanX = NULL;
+static float* beanY = NULL;
+static float* beanZ = NULL;
+static Color* beanColors = NULL;
+static int* beanIds = NULL;
+static unsigned char* beanVisible = NULL;
+static unsigned char* beanLod = NULL;
+static unsigned char* beanOutline = NULL;
+static int beanCount = 0;
+static int beanCapacity = 0;
+
+// hands queued this frame, the same way
+static float* handX = NULL;
+static float* handY = NULL;
+static float* handZ = NULL;
+static Color* handColors = NULL;
+static unsigned char* handVisible = NULL;
+static int handCount = 0;
+static int handCapacity = 0;
+
+// last level picked for each id, that's what the hysteresis works from
+static unsigned char* lodHistory = NULL;
+static int lodHistoryCapacity = 0;
+
+// built from the visible beans right before drawing, grouped by level with outlined ones first in each group,
+// then the visible hands after all of them
+static BeanInstance* instances = NULL;
+static int instanceCapacity = 0;
+static int instanceCount = 0;
+static int handFirst = 0;
+static int handsDrawn = 0;
+static int groupFirst[BEAN_LODS];
+static int groupCount[BEAN_LODS];
+static int groupOutlined[BEAN_LODS];
+
+// capsule as two hemispheres, top one from the pole down to its equator then the bottom one from its equator down
+// the rows between the two equators make up the cylinder
+static void BuildCapsule(BeanLod* lod, int rings, int slices)
+{
+    int half = rings / 2;
+    int rows = 2 * (half + 1);
+    int cols = slices + 1;
+    int base = vertexCount;
+
+    for (int row = 0; row < rows; row++) {
+        float phi;
+        float offset;
+        if (row <= half) {
+            phi = PI / 2.0f - row * (PI / 2.0f) / half;
+            offset = BEAN_TOP_OFFSET;
+        } else {
+            phi = -(row - half - 1) * (PI / 2.0f) / half;
+            offset = BEAN_BOTTOM_OFFSET;
+        }
+
+        for (int col = 0; col < cols; col++) {
+            float theta = col * 2.0f * PI / slices;
+            vertices[vertexCount++] = (Vector3){
+                cosf(phi) * sinf(theta) * BEAN_RADIUS,
+                sinf(phi) * BEAN_RADIUS + offset,
+                cosf(phi) * cosf(theta) * BEAN_RADIUS
+            };
+        }
+    }
+
+    lod->triangleFirst = indexCount;
+    for (int row = 0; row < rows - 1; row++) {
+        for (int col = 0; col < slices; col++) {
+            unsigned short a = base + row * cols + col;
+            unsigned short b = a + cols;
+            indices[indexCount++] = a;
+            indices[indexCount++] = b;
+            indices[indexCount++] = a + 1;
+            indices[indexCount++] = a + 1;
+            indices[indexCount++] = b;
+            indices[indexCount++] = b + 1;
+        }
+    }
+    lod->triangleCount = indexCount - lod->triangleFirst;
+
+    // outline goes right after the triangles. rings around (skipping the poles, they're a single point) and lines down
+    lod->lineFirst = indexCount;
+    for (int row = 1; row < rows - 1; row++) {
+        for (int col = 0; col < slices; col++) {
+            indices[indexCount++] = base + row * cols + col;
+            indices[indexCount++] = base + row * cols + col + 1;
+        }
+    }
+    for (int row = 0; row < rows - 1; row++) {
+        for (int col = 0; col < slices; col++) {
+            indices[indexCount++] = base + row * cols + col;
+            indices[indexCount++] = base + (row + 1) * cols + col;
+        }
+    }
+    lod->lineCount = indexCount - lod->lineFirst;
+}
+
+// flat capsule outline in the xy plane, x gets turned towards the camera when drawn
+static void BuildImpostor(BeanLod* lod)
+{
+    int center = vertexCount;
+    vertices[vertexCount++] = (Vector3){ 0.0f, (BEAN_TOP_OFFSET + BEAN_BOTTOM_OFFSET) * 0.5f, 0.0f };
+
+    // counter clockwise, top half circle then the bottom one
+    int first = vertexCount;
+    for (int i = 0; i <= 2 * BEAN_IMPOSTOR_SEGMENTS + 1; i++) {
+        bool top = i <= BEAN_IMPOSTOR_SEGMENTS;
+        int step = top ? i : i - 1;
+        float angle = step * PI / BEAN_IMPOSTOR_SEGMENTS;
+        vertices[vertexCount++] = (Vector3){
+            cosf(angle) * BEAN_RADIUS,
+            sinf(angle) * BEAN_RADIUS + (top ? BEAN_TOP_OFFSET : BEAN_BOTTOM_OFFSET),
+            0.0f
+        };
+    }
+    int perimeter = vertexCount - first;
+
+    lod->triangleFirst = indexCount;
+    for (int i = 0; i < perimeter; i++) {
+        indices[indexCount++] = center;
+        indices[indexCount++] = first + i;
+        indices[indexCount++] = first + (i + 1) % perimeter;
+    }
+    lod->triangleCount = indexCount - lod->triangleFirst;
+    lod->lineFirst = indexCount;
+    lod->lineCount = 0;
+}
+
+// plain uv sphere around the origin, no outline
+static void BuildSphere(BeanLod* mesh, int rings, int slices, float radius)
+{
+    int cols = slices + 1;
+    int base = vertexCount;
+
+    for (int row = 0; row <= rings; row++) {
+        float phi = PI / 2.0f - row * PI / rings;
+        for (int col = 0; col < cols; col++) {
+            float theta = col * 2.0f * PI / slices;
+            vertices[vertexCount++] = (Vector3){ cosf(phi) * sinf(theta) * radius, sinf(phi) * radius, cosf(phi) * cosf(theta) * radius };
+        }
+    }
+
+    mesh->triangleFirst = indexCount;
+    for (int row = 0; row < rings; row++) {
+        for (int col = 0; col < slices; col++) {
+            unsigned short a = base + row * cols + col;
+            unsigned short b = a + cols;
+            indices[indexCount++] = a;
+            indices[indexCount++] = b;
+            indices[indexCount++] = a + 1;
+            indices[indexCount++] = a + 1;
+            indices[indexCount++] = b;
+            indices[indexCount++] = b + 1;
+        }
+    }
+    mesh->triangleCount = indexCount - mesh->triangleFirst;
+    mesh->lineFirst = indexCount;
+    mesh->lineCount = 0;
+}
+
+static void BuildMeshes(void)
+{
+    vertexCount = 0;
+    indexCount = 0;
+    for (int i = 0; i < BEAN_MESH_LODS; i++) BuildCapsule(&lods[i], lodRings[i], lodSlices[i]);
+    BuildImpostor(&lods[BEAN_IMPOSTOR_LOD]);
+    BuildSphere(&handMesh, HAND_RINGS, HAND_SLICES, BEAN_HAND_RADIUS);
+}
+
+static void BindInstanceAttributes(int firstInstance)
+{
+    size_t offset = (size_t)firstInstance * sizeof(BeanInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (int i = 0; i < 4; i++) {
+        glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, sizeof(BeanInstance), (void*)(offset + i * 4 * sizeof(float)));
+    }
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BeanInstance), (void*)(offset + offsetof(BeanInstance, color)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool InitBeanRenderer(void)
+{
+    BuildMeshes();
+
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version == NULL || strncmp(version, "OpenGL ES 3", 11) != 0) {
+        TraceLog(LOG_WARNING, "BEANS: No instancing on %s, using the batched path", version ? version : "?");
+        return false;
+    }
+
+    shader = LoadStereoShader(beanVertexShader, beanFragmentShader);
+    if (shader.id == 0) {
+        TraceLog(LOG_WARNING, "BEANS: Instanced shader failed, using the batched path");
+        return false;
+    }
+    outlineLoc = rlGetLocationUniform(shader.id, "outline");
+    billboardLoc = rlGetLocationUniform(shader.id, "billboard");
+    billboardRightLoc = rlGetLocationUniform(shader.id, "billboardRight");
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vector3), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3), (void*)0);
+
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned short), indices, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &instanceBuffer);
+    for (int i = 1; i <= 5; i++) glEnableVertexAttribArray(i);
+    BindInstanceAttributes(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    instanced = true;
+    return true;
+}
+
+void UnloadBeanRenderer(void)
+{
+    if (instanced) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        glDeleteBuffers(1, &instanceBuffer);
+        UnloadStereoShader(shader);
+        instanced = false;
+    }
+
+    free(beanX);
+    free(beanY);
+    free(beanZ);
+    free(beanColors);
+    free(beanIds);
+    free(beanVisible);
+    free(beanLod);
+    free(beanOutline);
+    free(handX);
+    free(handY);
+    free(handZ);
+    free(handColors);
+    free(handVisible);
+    free(instances);
+    free(lodHistory);
+    beanX = beanY = beanZ = NULL;
+    beanColors = NULL;
+    beanIds = NULL;
+    beanVisible = beanLod = beanOutline = NULL;
+    handX = handY = handZ = NULL;
+    handColors = NULL;
+    handVisible = NULL;
+    instances = NULL;
+    lodHistory = NULL;
+    beanCount = 0;
+    beanCapacity = 0;
+    handCount = 0;
+    handCapacity = 0;
+    lodHistoryCapacity = 0;
+    instanceCapacity = 0;
+    instanceCount = 0;
+    instanceBufferCapacity = 0;
+}
+
+void SetBeanLodBias(float bias)
+{
+    lodBias = bias;
+}
+
+float GetBeanLodBias(void)
+{
+    return lodBias;
+}
+
+void BeginBeans(void)
+{
+    beanCount = 0;
+    handCount = 0;
+}
+
+void PushBean(int id, Vector3 position, Color color)
+{
+    if (beanCount == beanCapacity) {
+        beanCapacity = beanCapacity ? beanCapacity * 2 : 16;
+        beanX = realloc(beanX, beanCapacity * sizeof(float));
+        beanY = realloc(beanY, beanCapacity * sizeof(float));
+        beanZ = realloc(beanZ, beanCapacity * sizeof(float));
+        beanColors = realloc(beanColors, beanCapacity * sizeof(Color));
+        beanIds = realloc(beanIds, beanCapacity * sizeof(int));
+        beanVisible = realloc(beanVisible, beanCapacity);
+        beanLod = realloc(beanLod, beanCapacity);
+        beanOutline = realloc(beanOutline, beanCapacity);
+    }
+
+    if (id >= lodHistoryCapacity) {
+        int capacity = lodHistoryCapacity ? lodHistoryCapacity : 16;
+        while (capacity <= id) capacity *= 2;
+        lodHistory = realloc(lodHistory, capacity);
+        memset(lodHistory + lodHistoryCapacity, 0, capacity - lodHistoryCapacity);
+        lodHistoryCapacity = capacity;
+    }
+
+    beanX[beanCount] = position.x;
+    beanY[beanCount] = position.y;
+    beanZ[beanCount] = position.z;
+    beanColors[beanCount] = color;
+    beanIds[beanCount] = id;
+    beanVisible[beanCount] = 1;
+    beanCount++;
+}
+
+void PushHand(Vector3 position, Color color)
+{
+    if (handCount == handCapacity) {
+        handCapacity = handCapacity ? handCapacity * 2 : 16;
+        handX = realloc(handX, handCapacity * sizeof(float));
+        handY = realloc(handY, handCapacity * sizeof(float));
+        handZ = realloc(handZ, handCapacity * sizeof(float));
+        handColors = realloc(handColors, handCapacity * sizeof(Color));
+        handVisible = realloc(handVisible, handCapacity);
+    }
+
+    handX[handCount] = position.x;
+    handY[handCount] = position.y;
+    handZ[handCount] = position.z;
+    handColors[handCount] = color;
+    handVisible[handCount] = 1;
+    handCount++;
+}
+
+void CullBeans(const Frustum* frustum)
+{
+    if (beanCount == 0 && handCount == 0) return;
+
+    TRACE_BEGIN("cull beans");
+
+    // bounding sphere around the capsule, centered between the caps
+    float center = (BEAN_TOP_OFFSET + BEAN_BOTTOM_OFFSET) * 0.5f;
+    float radius = (BEAN_TOP_OFFSET - BEAN_BOTTOM_OFFSET) * 0.5f + BEAN_RADIUS;
+
+    // shift the frustum instead of every bean so the positions can go straight in
+    Frustum shifted = *frustum;
+    for (int p = 0; p < FRUSTUM_PLANES; p++) shifted.distance[p] += shifted.normal[p].y * center;
+
+    int drawn = CullSpheres(&shifted, beanX, beanY, beanZ, radius, beanCount, beanVisible);
+    int hands = CullSpheres(frustum, handX, handY, handZ, BEAN_HAND_RADIUS, handCount, handVisible);
+
+    TRACE_COUNTER("beans drawn", drawn);
+    TRACE_COUNTER("beans culled", beanCount - drawn);
+    TRACE_COUNTER("hands culled", handCount - hands);
+    TRACE_END("cull beans");
+}
+
+// first level whose threshold the size still clears
+static int LodForSize(float size)
+{
+    for (int i = 0; i < BEAN_LODS - 1; i++) {
+        if (size >= lodSizes[i] * lodBias) return i;
+    }
+    return BEAN_IMPOSTOR_LOD;
+}
+
+static void SelectLods(Vector3 eye, float projectionScale)
+{
+    float radius = (BEAN_TOP_OFFSET - BEAN_BOTTOM_OFFSET) * 0.5f + BEAN_RADIUS;
+    float center = (BEAN_TOP_OFFSET + BEAN_BOTTOM_OFFSET) * 0.5f;
+    float outlineDistance = BEAN_OUTLINE_DISTANCE / lodBias;
+
+    for (int i = 0; i < beanCount; i++) {
+        if (!beanVisible[i]) continue;
+
+        float dx = beanX[i] - eye.x;
+        float dy = beanY[i] + center - eye.y;
+        float dz = beanZ[i] - eye.z;
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+        float size = distance > radius ? radius * projectionScale / distance : 1e9f;
+
+        int lod;
+        int id = beanIds[i];
+        if (id < 0) {
+            lod = LodForSize(size);
+        } else {
+            // only move a level if the size is clearly past the threshold
+            lod = lodHistory[id];
+            int finer = LodForSize(size / (1.0f + BEAN_LOD_BAND));
+            int coarser = LodForSize(size / (1.0f - BEAN_LOD_BAND));
+            if (finer < lod) lod = finer;
+            else if (coarser > lod) lod = coarser;
+            lodHistory[id] = lod;
+        }
+
+        beanLod[i] = lod;
+        beanOutline[i] = lod != BEAN_IMPOSTOR_LOD && distance < outlineDistance;
+    }
+}
+
+static void SetInstance(BeanInstance* instance, float x, float y, float z, Color color)
+{
+    memcpy(instance->transform, MatrixToFloatV(MatrixTranslate(x, y, z)).v, sizeof(instance->transform));
+    instance->color[0] = color.r;
+    instance->color[1] = color.g;
+    instance->color[2] = color.b;
+    instance->color[3] = color.a;
+}
+
+// counting sort into one group per level, outlined beans at the front of each group, hands on the end
+static void BuildInstances(void)
+{
+    if (beanCount + handCount > instanceCapacity) {
+        instanceCapacity = beanCapacity + handCapacity;
+        instances = realloc(instances, instanceCapacity * sizeof(BeanInstance));
+    }
+
+    memset(groupCount, 0, sizeof(groupCount));
+    memset(groupOutlined, 0, sizeof(groupOutlined));
+    for (int i = 0; i < beanCount; i++) {
+        if (!beanVisible[i]) continue;
+        groupCount[beanLod[i]]++;
+        groupOutlined[beanLod[i]] += beanOutline[i];
+    }
+
+    int next[BEAN_LODS];
+    int nextPlain[BEAN_LODS];
+    instanceCount = 0;
+    for (int lod = 0; lod < BEAN_LODS; lod++) {
+        groupFirst[lod] = instanceCount;
+        next[lod] = instanceCount;
+        nextPlain[lod] = instanceCount + groupOutlined[lod];
+        instanceCount += groupCount[lod];
+    }
+
+    for (int i = 0; i < beanCount; i++) {
+        if (!beanVisible[i]) continue;
+
+        int lod = beanLod[i];
+        SetInstance(&instances[beanOutline[i] ? next[lod]++ : nextPlain[lod]++], beanX[i], beanY[i], beanZ[i], beanColors[i]);
+    }
+
+    handFirst = instanceCount;
+    for (int i = 0; i < handCount; i++) {
+        if (handVisible[i]) SetInstance(&instances[instanceCount++], handX[i], handY[i], handZ[i], handColors[i]);
+    }
+    handsDrawn = instanceCount - handFirst;
+
+    for (int lod = 0; lod < BEAN_LODS; lod++) {
+        TRACE_COUNTER(lod == 0 ? "beans lod0" : lod == 1 ? "beans lod1" : lod == 2 ? "beans lod2" : "beans impostor", groupCount[lod]);
+    }
+}
+
+static void PushBatchedMesh(const BeanInstance* instance, int first, int count, bool billboard, Vector3 right)
+{
+    const float* m = instance->transform;
+    for (int i = first; i < first + count; i++) {
+        Vector3 v = vertices[indices[i]];
+        if (billboard) {
+            rlVertex3f(m[12] + right.x * v.x, m[13] + v.y, m[14] + right.z * v.x);
+        } else {
+            rlVertex3f(
+                m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12],
+                m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13],
+                m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14]
+            );
+        }
+    }
+}
+
+// no instancing, still skips regenerating the capsule every time by reusing the cached meshes
+static void DrawBeansBatched(Vector3 right)
+{
+    for (int lod = 0; lod < BEAN_LODS; lod++) {
+        const BeanLod* mesh = &lods[lod];
+        bool billboard = lod == BEAN_IMPOSTOR_LOD;
+
+        for (int i = groupFirst[lod]; i < groupFirst[lod] + groupCount[lod]; i++) {
+            const BeanInstance* instance = &instances[i];
+            bool outline = i < groupFirst[lod] + groupOutlined[lod];
+
+            rlCheckRenderBatchLimit(mesh->triangleCount + (outline ? mesh->lineCount : 0));
+
+            rlBegin(RL_TRIANGLES);
+            rlColor4ub(instance->color[0], instance->color[1], instance->color[2], instance->color[3]);
+            PushBatchedMesh(instance, mesh->triangleFirst, mesh->triangleCount, billboard, right);
+            rlEnd();
+
+            if (outline) {
+                rlBegin(RL_LINES);
+                rlColor4ub(0, 0, 0, 255);
+                PushBatchedMesh(instance, mesh->lineFirst, mesh->lineCount, billboard, right);
+                rlEnd();
+            }
+        }
+    }
+
+    for (int i = handFirst; i < handFirst + handsDrawn; i++) {
+        const BeanInstance* instance = &instances[i];
+        rlCheckRenderBatchLimit(handMesh.triangleCount);
+        rlBegin(RL_TRIANGLES);
+        rlColor4ub(instance->color[0], instance->color[1], instance->color[2], instance->color[3]);
+        PushBatchedMesh(instance, handMesh.triangleFirst, handMesh.triangleCount, false, right);
+        rlEnd();
+    }
+}
+
+void DrawBeans(void)
+{
+    if (beanCount == 0 && handCount == 0) return;
+
+    TRACE_BEGIN("draw beans");
+
+    // camera position and right vector come out of the view matrix, the projection gives how big things look
+    Matrix view = rlGetMatrixModelview();
+    Matrix viewInverse = MatrixInvert(view);
+    Vector3 eye = { viewInverse.m12, viewInverse.m13, viewInverse.m14 };
+    Matrix projection = rlIsStereoRenderEnabled() ? rlGetMatrixProjectionStereo(0) : rlGetMatrixProjection();
+    // impostors only turn around the vertical axis so beans stay upright
+    Vector3 right = Vector3Normalize((Vector3){ view.m0, 0.0f, view.m8 });
+
+    SelectLods(eye, projection.m5);
+    BuildInstances();
+
+    if (instanceCount == 0) {
+        TRACE_END("draw beans");
+        return;
+    }
+
+    if (!instanced) {
+        DrawBeansBatched(right);
+        TRACE_END("draw beans");
+        return;
+    }
+
+    // orphan the old storage so we don't wait on the gpu still reading last frame's instances
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (instanceCount > instanceBufferCapacity) instanceBufferCapacity = instanceCapacity;
+    glBufferData(GL_ARRAY_BUFFER, instanceBufferCapacity * sizeof(BeanInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(BeanInstance), instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    int passes = BeginStereoDraw(shader);
+    glBindVertexArray(vao);
+    glUniform3f(billboardRightLoc, right.x, right.y, right.z);
+
+    // in single pass every bean is drawn once per eye, so its instance data has to advance every other instance
+    int divisor = StereoInstanceDivisor();
+    for (int i = 1; i <= 5; i++) glVertexAttribDivisor(i, divisor);
+
+    for (int pass = 0; pass < passes; pass++) {
+        SetStereoPass(shader, pass);
+
+        // no base instance in gles 3.0, so each group points the instance attributes at its own start
+        for (int lod = 0; lod < BEAN_LODS; lod++) {
+            if (groupCount[lod] == 0) continue;
+            const BeanLod* mesh = &lods[lod];
+            BindInstanceAttributes(groupFirst[lod]);
+
+            glUniform1f(billboardLoc, lod == BEAN_IMPOSTOR_LOD ? 1.0f : 0.0f);
+            glUniform1f(outlineLoc, 0.0f);
+            glDrawElementsInstanced(GL_TRIANGLES, mesh->triangleCount, GL_UNSIGNED_SHORT, (void*)(mesh->triangleFirst * sizeof(unsigned short)), StereoInstances(groupCount[lod]));
+
+            if (groupOutlined[lod] > 0 && mesh->lineCount > 0) {
+                glUniform1f(outlineLoc, 1.0f);
+                glDrawElementsInstanced(GL_LINES, mesh->lineCount, GL_UNSIGNED_SHORT, (void*)(mesh->lineFirst * sizeof(unsigned short)), StereoInstances(groupOutlined[lod]));
+            }
+        }
+
+        if (handsDrawn > 0) {
+            BindInstanceAttributes(handFirst);
+            glUniform1f(billboardLoc, 0.0f);
+            glUniform1f(outlineLoc, 0.0f);
+            glDrawElementsInstanced(GL_TRIANGLES, handMesh.triangleCount, GL_UNSIGNED_SHORT, (void*)(handMesh.triangleFirst * sizeof(unsigned short)), StereoInstances(handsDrawn));
+        }
+    }
+
+    glBindVertexArray(0);
+    EndStereoDraw();
+
+    TRACE_END("draw beans");
+}
@@ -0,0 +1,337 @@
+#include "collision.h"
+#include "raylib/raymath.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// deep enough for any tree BuildCollisionWorld makes, it splits down to a handful of items per leaf
+#define BVH_STACK 64
+#define BVH_LEAF_ITEMS 4
+
+// sweeps move at most this far between overlap checks, half the radius can't skip past anything
+#define SWEEP_STEP (BEAN_CAPSULE_RADIUS * 0.5f)
+#define SWEEP_MAX_STEPS 64
+// pushing out of one shape can push into another, a few rounds settles corners
+#define RESOLVE_ITERATIONS 4
+#define QUERY_ITEMS 64
+
+typedef struct BuildItem {
+    uint32_t ref;
+    Vector3 min;
+    Vector3 max;
+    Vector3 center;
+} BuildItem;
+
+static BuildItem* buildItems = NULL;
+static LevelBvhNode* buildNodes = NULL;
+static uint32_t buildNodeCount = 0;
+static int sortAxis = 0;
+
+static int CompareItems(const void* a, const void* b)
+{
+    float ca = ((const float*)&((const BuildItem*)a)->center)[sortAxis];
+    float cb = ((const float*)&((const BuildItem*)b)->center)[sortAxis];
+    return (ca > cb) - (ca < cb);
+}
+
+// median split on the longest axis of the item centers, depth first so the left child is always node + 1
+// a median split never makes more than 2n nodes, so buildNodes is allocated up front
+static uint32_t BuildNode(uint32_t first, uint32_t count)
+{
+    uint32_t index = buildNodeCount++;
+
+    Vector3 min = buildItems[first].min;
+    Vector3 max = buildItems[first].max;
+    Vector3 centerMin = buildItems[first].center;
+    Vector3 centerMax = buildItems[first].center;
+    for (uint32_t i = first + 1; i < first + count; i++) {
+        min = Vector3Min(min, buildItems[i].min);
+        max = Vector3Max(max, buildItems[i].max);
+        centerMin = Vector3Min(centerMin, buildItems[i].center);
+        centerMax = Vector3Max(centerMax, buildItems[i].center);
+    }
+
+    buildNodes[index] = (LevelBvhNode){ min, first, max, count };
+    if (count <= BVH_LEAF_ITEMS) return index;
+
+    Vector3 extent = Vector3Subtract(centerMax, centerMin);
+    sortAxis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    qsort(buildItems + first, count, sizeof(BuildItem), CompareItems);
+
+    uint32_t half = count / 2;
+    BuildNode(first, half);
+    uint32_t right = BuildNode(first + half, count - half);
+    buildNodes[index].firstOrRight = right;
+    buildNodes[index].count = 0;
+    return index;
+}
+
+void CollisionWorldFromLevel(CollisionWorld* world, const Level* level)
+{
+    *world = (CollisionWorld){
+        level->spheres, level->sphereCount,
+        level->boxes, level->boxCount,
+        level->nodes, level->nodeCount,
+        level->items, level->itemCount,
+        false
+    };
+}
+
+bool BuildCollisionWorld(CollisionWorld* world, const LevelSphere* spheres, uint32_t sphereCount, const BoundingBox* boxes, uint32_t boxCount)
+{
+    memset(world, 0, sizeof(CollisionWorld));
+    uint32_t itemCount = sphereCount + boxCount;
+
+    LevelSphere* ownSpheres = malloc(sphereCount * sizeof(LevelSphere) + 1);
+    BoundingBox* ownBoxes = malloc(boxCount * sizeof(BoundingBox) + 1);
+    uint32_t* items = malloc(itemCount * sizeof(uint32_t) + 1);
+    buildItems = malloc(itemCount * sizeof(BuildItem) + 1);
+    buildNodes = malloc(2 * itemCount * sizeof(LevelBvhNode) + 1);
+    buildNodeCount = 0;
+
+    if (ownSpheres == NULL || ownBoxes == NULL || items == NULL || buildItems == NULL || buildNodes == NULL) {
+        free(ownSpheres);
+        free(ownBoxes);
+        free(items);
+        free(buildItems);
+        free(buildNodes);
+        buildItems = NULL;
+        buildNodes = NULL;
+        return false;
+    }
+
+    if (sphereCount > 0) memcpy(ownSpheres, spheres, sphereCount * sizeof(LevelSphere));
+    if (boxCount > 0) memcpy(ownBoxes, boxes, boxCount * sizeof(BoundingBox));
+
+    for (uint32_t i = 0; i < sphereCount; i++) {
+        LevelSphere s = spheres[i];
+        Vector3 r = { s.radius, s.radius, s.radius };
+        buildItems[i] = (BuildItem){ i, Vector3Subtract(s.center, r), Vector3Add(s.center, r), s.center };
+    }
+    for (uint32_t i = 0; i < boxCount; i++) {
+        buildItems[sphereCount + i] = (BuildItem){ i | LEVEL_ITEM_BOX, boxes[i].min, boxes[i].max, Vector3Scale(Vector3Add(boxes[i].min, boxes[i].max), 0.5f) };
+    }
+
+    if (itemCount > 0) BuildNode(0, itemCount);
+    for (uint32_t i = 0; i < itemCount; i++) items[i] = buildItems[i].ref;
+
+    *world = (CollisionWorld){
+        ownSpheres, sphereCount,
+        ownBoxes, boxCount,
+        buildNodes, buildNodeCount,
+        items, itemCount,
+        true
+    };
+
+    free(buildItems);
+    buildItems = NULL;
+    buildNodes = NULL;
+    return true;
+}
+
+void UnloadCollisionWorld(CollisionWorld* world)
+{
+    if (world->owned) {
+        free((void*)world->spheres);
+        free((void*)world->boxes);
+        free((void*)world->nodes);
+        free((void*)world->items);
+    }
+    memset(world, 0, sizeof(CollisionWorld));
+}
+
+static bool Overlaps(Vector3 min, Vector3 max, BoundingBox area)
+{
+    return min.x <= area.max.x && max.x >= area.min.x &&
+           min.y <= area.max.y && max.y >= area.min.y &&
+           min.z <= area.max.z && max.z >= area.min.z;
+}
+
+uint32_t QueryCollisionWorld(const CollisionWorld* world, BoundingBox area, uint32_t* items, uint32_t maxItems)
+{
+    if (world->nodeCount == 0) return 0;
+
+    uint32_t found = 0;
+    uint32_t stack[BVH_STACK];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const LevelBvhNode* node = &world->nodes[index];
+        if (!Overlaps(node->min, node->max, area)) continue;
+
+        if (node->count > 0) {
+            for (uint32_t i = 0; i < node->count; i++) {
+                uint32_t ref = world->items[node->firstOrRight + i];
+                uint32_t item = LEVEL_ITEM_INDEX(ref);
+
+                // leaves group nearby shapes, still check each one on its own
+                bool hit;
+                if (ref & LEVEL_ITEM_BOX) {
+                    hit = Overlaps(world->boxes[item].min, world->boxes[item].max, area);
+                } else {
+                    LevelSphere s = world->spheres[item];
+                    Vector3 r = { s.radius, s.radius, s.radius };
+                    hit = Overlaps(Vector3Subtract(s.center, r), Vector3Add(s.center, r), area);
+                }
+
+                if (hit) {
+                    if (found < maxItems) items[found] = ref;
+                    found++;
+                }
+            }
+            continue;
+        }
+
+        if (top + 2 > BVH_STACK) break;
+        stack[top++] = node->firstOrRight;
+        stack[top++] = index + 1;
+    }
+
+    return found;
+}
+
+static BoundingBox CapsuleBounds(Vector3 position)
+{
+    return (BoundingBox){
+        { position.x - BEAN_CAPSULE_RADIUS, position.y + BEAN_CAPSULE_BOTTOM - BEAN_CAPSULE_RADIUS, position.z - BEAN_CAPSULE_RADIUS },
+        { position.x + BEAN_CAPSULE_RADIUS, position.y + BEAN_CAPSULE_TOP + BEAN_CAPSULE_RADIUS, position.z + BEAN_CAPSULE_RADIUS }
+    };
+}
+
+// the capsule is always upright, so its segment is a vertical line at position.x, position.z
+// both of these give the way out and how far to go when the capsule overlaps the shape
+static bool CapsuleSphere(Vector3 position, LevelSphere sphere, Vector3* normal, float* depth)
+{
+    float y = Clamp(sphere.center.y, position.y + BEAN_CAPSULE_BOTTOM, position.y + BEAN_CAPSULE_TOP);
+    Vector3 d = { position.x - sphere.center.x, y - sphere.center.y, position.z - sphere.center.z };
+    float reach = BEAN_CAPSULE_RADIUS + sphere.radius;
+    float distance2 = Vector3DotProduct(d, d);
+    if (distance2 >= reach * reach) return false;
+
+    float distance = sqrtf(distance2);
+    *normal = distance > 1e-6f ? Vector3Scale(d, 1.0f / distance) : (Vector3){ 0.0f, 1.0f, 0.0f };
+    *depth = reach - distance;
+    return true;
+}
+
+static bool CapsuleBox(Vector3 position, BoundingBox box, Vector3* normal, float* depth)
+{
+    const float r = BEAN_CAPSULE_RADIUS;
+    float bottom = position.y + BEAN_CAPSULE_BOTTOM;
+    float top = position.y + BEAN_CAPSULE_TOP;
+
+    // closest points between the segment and the box
+    Vector3 onBox = { Clamp(position.x, box.min.x, box.max.x), 0.0f, Clamp(position.z, box.min.z, box.max.z) };
+    Vector3 onSegment = { position.x, 0.0f, position.z };
+    if (top < box.min.y) {
+        onSegment.y = top;
+        onBox.y = box.min.y;
+    } else if (bottom > box.max.y) {
+        onSegment.y = bottom;
+        onBox.y = box.max.y;
+    } else {
+        onSegment.y = onBox.y = fmaxf(bottom, box.min.y);
+    }
+
+    Vector3 d = Vector3Subtract(onSegment, onBox);
+    float distance2 = Vector3DotProduct(d, d);
+    if (distance2 >= r * r) return false;
+
+    if (distance2 > 1e-12f) {
+        float distance = sqrtf(distance2);
+        *normal = Vector3Scale(d, 1.0f / distance);
+        *depth = r - distance;
+        return true;
+    }
+
+    // the segment goes right through the box, leave by whichever side is closest
+    float exits[6] = {
+        position.x + r - box.min.x, box.max.x - (position.x - r),
+        top + r - box.min.y, box.max.y - (bottom - r),
+        position.z + r - box.min.z, box.max.z - (position.z - r)
+    };
+    static const Vector3 directions[6] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+    int best = 0;
+    for (int i = 1; i < 6; i++) {
+        if (exits[i] < exits[best]) best = i;
+    }
+    *normal = directions[best];
+    *depth = exits[best];
+    return true;
+}
+
+Vector3 SweepBean(const CollisionWorld* world, Vector3 position, Vector3 delta, bool* grounded)
+{
+    if (grounded != NULL) *grounded = false;
+
+    int steps = (int)ceilf(Vector3Length(delta) / SWEEP_STEP);
+    if (steps < 1) steps = 1;
+    if (steps > SWEEP_MAX_STEPS) steps = SWEEP_MAX_STEPS;
+    Vector3 step = Vector3Scale(delta, 1.0f / steps);
+
+    for (int s = 0; s < steps; s++) {
+        position = Vector3Add(position, step);
+
+        for (int iteration = 0; iteration < RESOLVE_ITERATIONS; iteration++) {
+            uint32_t refs[QUERY_ITEMS];
+            uint32_t count = QueryCollisionWorld(world, CapsuleBounds(position), refs, QUERY_ITEMS);
+            if (count > QUERY_ITEMS) count = QUERY_ITEMS;
+
+            bool hit = false;
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t item = LEVEL_ITEM_INDEX(refs[i]);
+                Vector3 normal;
+                float depth;
+                bool touching = (refs[i] & LEVEL_ITEM_BOX) ? CapsuleBox(position, world->boxes[item], &normal, &depth)
+                                                           : CapsuleSphere(position, world->spheres[item], &normal, &depth);
+                if (!touching) continue;
+
+                position = Vector3Add(position, Vector3Scale(normal, depth));
+                hit = true;
+                if (grounded != NULL && normal.y > BEAN_FLOOR_NORMAL) *grounded = true;
+
+                // slide: whatever is left of the move loses the part going into the surface
+                float into = Vector3DotProduct(step, normal);
+                if (into < 0.0f) step = Vector3Subtract(step, Vector3Scale(normal, into));
+            }
+            if (!hit) break;
+        }
+    }
+
+    return position;
+}
+
+static float HorizontalDistance(Vector3 a, Vector3 b)
+{
+    return Vector2Distance((Vector2){ a.x, a.z }, (Vector2){ b.x, b.z });
+}
+
+Vector3 MoveBean(const CollisionWorld* world, BeanBody* body, Vector3 position, Vector3 walk, float dt)
+{
+    walk.y = 0.0f;
+
+    if (walk.x != 0.0f || walk.z != 0.0f) {
+        Vector3 moved = SweepBean(world, position, walk, NULL);
+
+        // try the same walk from a step higher and settle back down, if that got further and landed on something we walked up a step
+        if (body->grounded) {
+            Vector3 up = SweepBean(world, position, (Vector3){ 0.0f, BEAN_STEP_HEIGHT, 0.0f }, NULL);
+            Vector3 across = SweepBean(world, up, walk, NULL);
+            bool landed = false;
+            Vector3 down = SweepBean(world, across, (Vector3){ 0.0f, position.y - up.y - 0.01f, 0.0f }, &landed);
+            if (landed && HorizontalDistance(down, position) > HorizontalDistance(moved, position) + 0.001f) moved = down;
+        }
+
+        position = moved;
+    }
+
+    body->fallSpeed -= BEAN_GRAVITY * dt;
+    if (body->fallSpeed < -BEAN_TERMINAL_SPEED) body->fallSpeed = -BEAN_TERMINAL_SPEED;
+
+    position = SweepBean(world, position, (Vector3){ 0.0f, body->fallSpeed * dt, 0.0f }, &body->grounded);
+    if (body->grounded && body->fallSpeed < 0.0f) body->fallSpeed = 0.0f;
+
+    return position;
+}
@@ -0,0 +1,98 @@
+#include "cull.h"
+#include "raylib/raymath.h"
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CULL_NEON 1
+#else
+#define CULL_NEON 0
+#endif
+
+static void SetPlane(Frustum* frustum, int plane, Vector3 normal, float distance)
+{
+    float length = Vector3Length(normal);
+    frustum->normal[plane] = Vector3Scale(normal, 1.0f / length);
+    frustum->distance[plane] = distance / length;
+}
+
+Frustum StereoFrustum(float tanLeft, float tanRight, float tanDown, float tanUp, float eyeSpread, float farDistance)
+{
+    Frustum frustum = { 0 };
+
+    // the narrowest side decides how far back the apex has to go for a ball of radius eyeSpread around the head to fit
+    float narrowest = fminf(fminf(-tanLeft, tanRight), fminf(-tanDown, tanUp));
+    float back = 0.0f;
+    if (narrowest > 0.0f) back = eyeSpread * sqrtf(1.0f + narrowest * narrowest) / narrowest;
+
+    // e.g. left is x >= tanLeft * (-z + back)
+    SetPlane(&frustum, 0, (Vector3){ 1.0f, 0.0f, tanLeft }, -tanLeft * back);
+    SetPlane(&frustum, 1, (Vector3){ -1.0f, 0.0f, -tanRight }, tanRight * back);
+    SetPlane(&frustum, 2, (Vector3){ 0.0f, 1.0f, tanDown }, -tanDown * back);
+    SetPlane(&frustum, 3, (Vector3){ 0.0f, -1.0f, -tanUp }, tanUp * back);
+    SetPlane(&frustum, 4, (Vector3){ 0.0f, 0.0f, 1.0f }, farDistance);
+
+    return frustum;
+}
+
+Frustum TransformFrustum(Frustum frustum, Matrix headToWorld)
+{
+    Vector3 translation = { headToWorld.m12, headToWorld.m13, headToWorld.m14 };
+    Frustum out = { 0 };
+
+    for (int i = 0; i < FRUSTUM_PLANES; i++) {
+        Vector3 n = frustum.normal[i];
+        // rotate only, the translation moves into the distance
+        out.normal[i] = (Vector3){
+            headToWorld.m0 * n.x + headToWorld.m4 * n.y + headToWorld.m8 * n.z,
+            headToWorld.m1 * n.x + headToWorld.m5 * n.y + headToWorld.m9 * n.z,
+            headToWorld.m2 * n.x + headToWorld.m6 * n.y + headToWorld.m10 * n.z
+        };
+        out.distance[i] = frustum.distance[i] - Vector3DotProduct(out.normal[i], translation);
+    }
+
+    return out;
+}
+
+int CullSpheres(const Frustum* frustum, const float* x, const float* y, const float* z, float radius, int count, unsigned char* visible)
+{
+    int i = 0;
+
+#if CULL_NEON
+    // 4 spheres at a time, every plane against every lane
+    float32x4_t negRadius = vdupq_n_f32(-radius);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t px = vld1q_f32(x + i);
+        float32x4_t py = vld1q_f32(y + i);
+        float32x4_t pz = vld1q_f32(z + i);
+        uint32x4_t inside = vdupq_n_u32(0xffffffff);
+
+        for (int p = 0; p < FRUSTUM_PLANES; p++) {
+            float32x4_t d = vdupq_n_f32(frustum->distance[p]);
+            d = vmlaq_n_f32(d, px, frustum->normal[p].x);
+            d = vmlaq_n_f32(d, py, frustum->normal[p].y);
+            d = vmlaq_n_f32(d, pz, frustum->normal[p].z);
+            inside = vandq_u32(inside, vcgeq_f32(d, negRadius));
+        }
+
+        visible[i + 0] = vgetq_lane_u32(inside, 0) & 1;
+        visible[i + 1] = vgetq_lane_u32(inside, 1) & 1;
+        visible[i + 2] = vgetq_lane_u32(inside, 2) & 1;
+        visible[i + 3] = vgetq_lane_u32(inside, 3) & 1;
+    }
+#endif
+
+    // whatever's left over, or everything when there's no neon. kept branch free so the compiler can vectorize it
+    for (; i < count; i++) {
+        unsigned char inside = 1;
+        for (int p = 0; p < FRUSTUM_PLANES; p++) {
+            float d = frustum->normal[p].x * x[i] + frustum->normal[p].y * y[i] + frustum->normal[p].z * z[i] + frustum->distance[p];
+            inside &= d >= -radius;
+        }
+        visible[i] = inside;
+    }
+
+    int visibleCount = 0;
+    for (i = 0; i < count; i++) visibleCount += visible[i];
+    return visibleCount;
+}
@@ -0,0 +1,202 @@
+#include "governor.h"
+#include "bean_render.h"
+#include "trace.h"
+#include "raylib/raylib.h"
+#include <GLES3/gl3.h>
+#include <string.h>
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+// quality steps from best to cheapest, cheap to lose stuff first and resolution last.
+// the cull distance only comes in at the bottom, where far beans pop out, and never below GOVERNOR_MIN_CULL
+typedef struct GovernorLevel {
+    float resolution;
+    float lodBias;
+    float cull;
+} GovernorLevel;
+
+static const GovernorLevel levels[] = {
+    { 1.0f, 1.0f, 1.0f },
+    { 1.0f, 1.5f, 1.0f },
+    { 0.9f, 1.5f, 1.0f },
+    { 0.8f, 2.0f, 1.0f },
+    { 0.7f, 2.5f, 0.85f },
+    { 0.6f, 3.0f, 0.7f },
+};
+#define GOVERNOR_LEVELS (int)(sizeof(levels) / sizeof(levels[0]))
+
+// fraction of the display period we're aiming for. drop a level quickly when over, only come back after a good while under
+#define GOVERNOR_OVER 0.92f
+#define GOVERNOR_UNDER 0.70f
+#define GOVERNOR_DOWN_FRAMES 10
+#define GOVERNOR_UP_FRAMES 90
+#define GOVERNOR_SMOOTHING 0.1f
+// far enough that anyone you could be playing with is still there
+#define GOVERNOR_MIN_CULL 0.7f
+
+// gpu timings come back a few frames late, so queries go round a small ring
+#define GOVERNOR_QUERIES 4
+
+// how often the resolution limited ratio gets logged
+#define GOVERNOR_REPORT_FRAMES 1000
+
+static bool governorEnabled = true;
+static int level = 0;
+static int framesSinceChange = 0;
+static float load = 0.0f;
+
+static int64_t period = 0;
+static uint64_t frameStart = 0;
+static uint64_t lastCpu = 0;
+static uint64_t lastGpu = 0;
+
+static bool gpuTimer = false;
+static GLuint queries[GOVERNOR_QUERIES];
+static bool queryPending[GOVERNOR_QUERIES];
+static int queryIndex = 0;
+static bool queryActive = false;
+
+static int reportFrames = 0;
+static int resolutionLimitedFrames = 0;
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension != NULL && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static void ApplyLevel(void)
+{
+    SetBeanLodBias(levels[level].lodBias);
+    TRACE_COUNTER("governor level", level);
+}
+
+void InitGovernor(void)
+{
+    gpuTimer = HasExtension("GL_EXT_disjoint_timer_query");
+    if (gpuTimer) glGenQueries(GOVERNOR_QUERIES, queries);
+    memset(queryPending, 0, sizeof(queryPending));
+
+    level = 0;
+    framesSinceChange = 0;
+    load = 0.0f;
+    ApplyLevel();
+
+    TraceLog(LOG_INFO, "GOVERNOR: GPU timing %s", gpuTimer ? "on" : "not supported, using CPU time only");
+}
+
+void UnloadGovernor(void)
+{
+    if (gpuTimer) glDeleteQueries(GOVERNOR_QUERIES, queries);
+    gpuTimer = false;
+}
+
+void GovernorBeginFrame(int64_t displayPeriod)
+{
+    period = displayPeriod;
+    frameStart = TraceNowNs();
+}
+
+void GovernorBeginGpu(void)
+{
+    if (!gpuTimer || queryPending[queryIndex]) return;
+    glBeginQuery(GL_TIME_ELAPSED_EXT, queries[queryIndex]);
+    queryActive = true;
+}
+
+void GovernorEndGpu(void)
+{
+    if (!queryActive) return;
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    queryActive = false;
+    queryPending[queryIndex] = true;
+    queryIndex = (queryIndex + 1) % GOVERNOR_QUERIES;
+}
+
+// pick up whatever gpu timings are ready without waiting on any
+static void CollectGpuTimes(void)
+{
+    if (!gpuTimer) return;
+
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    for (int i = 0; i < GOVERNOR_QUERIES; i++) {
+        if (!queryPending[i]) continue;
+
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint elapsed = 0;
+        glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &elapsed);
+        queryPending[i] = false;
+
+        // a disjoint event (power state change or similar) makes the result garbage
+        if (!disjoint) lastGpu = elapsed;
+    }
+}
+
+void GovernorEndFrame(void)
+{
+    lastCpu = TraceNowNs() - frameStart;
+    CollectGpuTimes();
+
+    TRACE_COUNTER("cpu frame us", lastCpu / 1000);
+    TRACE_COUNTER("gpu frame us", lastGpu / 1000);
+
+    if (period > 0) {
+        uint64_t busiest = lastCpu > lastGpu ? lastCpu : lastGpu;
+        float frameLoad = (float)busiest / (float)period;
+        load += (frameLoad - load) * GOVERNOR_SMOOTHING;
+    }
+    TRACE_COUNTER("frame load %", (int)(load * 100.0f));
+
+    framesSinceChange++;
+    if (governorEnabled) {
+        if (load > GOVERNOR_OVER && framesSinceChange >= GOVERNOR_DOWN_FRAMES && level < GOVERNOR_LEVELS - 1) {
+            level++;
+            framesSinceChange = 0;
+            ApplyLevel();
+        } else if (load < GOVERNOR_UNDER && framesSinceChange >= GOVERNOR_UP_FRAMES && level > 0) {
+            level--;
+            framesSinceChange = 0;
+            ApplyLevel();
+        }
+    }
+
+    reportFrames++;
+    if (levels[level].resolution < 1.0f) resolutionLimitedFrames++;
+    if (reportFrames >= GOVERNOR_REPORT_FRAMES) {
+        TRACE_COUNTER("resolution limited %", resolutionLimitedFrames * 100 / reportFrames);
+        TraceLog(LOG_INFO, "GOVERNOR: Resolution limited %d%% of the last %d frames, level %d, load %.2f",
+            resolutionLimitedFrames * 100 / reportFrames, reportFrames, level, load);
+        reportFrames = 0;
+        resolutionLimitedFrames = 0;
+    }
+}
+
+float GetGovernorResolutionScale(void)
+{
+    return levels[level].resolution;
+}
+
+float GetGovernorCullScale(void)
+{
+    return levels[level].cull > GOVERNOR_MIN_CULL ? levels[level].cull : GOVERNOR_MIN_CULL;
+}
+
+void SetGovernorEnabled(bool enabled)
+{
+    governorEnabled = enabled;
+}
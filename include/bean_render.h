@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include "raylib/raylib.h"
+#include "cull.h"
+#include "collision.h"
+
+// bean capsule, relative to the bean's position. drawn the same size it collides
+#define BEAN_RADIUS BEAN_CAPSULE_RADIUS
+#define BEAN_TOP_OFFSET BEAN_CAPSULE_TOP
+#define BEAN_BOTTOM_OFFSET BEAN_CAPSULE_BOTTOM
+// remote players' hands, just balls in their color for now
+#define BEAN_HAND_RADIUS 0.08f
+
+// builds the capsule and outline meshes once and draws every bean with one instanced draw (per eye when single pass stereo is off)
+// falls back to pushing the cached vertices through the rlgl batch when instancing isn't available
+// needs a GL context, call after InitWindow
+bool InitBeanRenderer(void);
+void UnloadBeanRenderer(void);
+
+// queue beans for this frame, then draw them all at once inside BeginMode3D
+void BeginBeans(void);
+// id keeps the level of detail steady from frame to frame, pass -1 if the bean doesn't have one
+void PushBean(int id, Vector3 position, Color color);
+// a hand goes in the same batch, culled and drawn along with the beans
+void PushHand(Vector3 position, Color color);
+// optional, drops queued beans and hands outside the (world space) frustum before they get drawn
+void CullBeans(const Frustum* frustum);
+void DrawBeans(void);
+
+// beans switch to cheaper meshes, lose their outline and end up as flat impostors as they get smaller on screen.
+// above 1 that happens sooner, below 1 later. meant to be turned by whatever is watching the frame budget
+void SetBeanLodBias(float bias);
+float GetBeanLodBias(void);
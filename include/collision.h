@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib/raylib.h"
+#include "level.h"
+
+// static collision and the bean character controller. no raylib calls and no GL in here,
+// the server links the same code so it moves beans exactly like the clients do
+
+// the bean's capsule relative to its position (the eye). topCap/botCap in player.c are these
+#define BEAN_CAPSULE_RADIUS 0.7f
+#define BEAN_CAPSULE_TOP 0.2f
+#define BEAN_CAPSULE_BOTTOM -1.0f
+
+// anything up to this high gets walked up onto instead of blocking
+#define BEAN_STEP_HEIGHT 0.35f
+#define BEAN_GRAVITY 9.8f
+#define BEAN_TERMINAL_SPEED 30.0f
+// surfaces whose normal points up more than this count as floor
+#define BEAN_FLOOR_NORMAL 0.7f
+
+// spheres and boxes with a flattened bvh over them (the same LevelBvhNode layout the level files store)
+// either points into a loaded level or owns arrays built at runtime
+typedef struct CollisionWorld {
+    const LevelSphere* spheres;
+    uint32_t sphereCount;
+    const BoundingBox* boxes;
+    uint32_t boxCount;
+    const LevelBvhNode* nodes;
+    uint32_t nodeCount;
+    const uint32_t* items;
+    uint32_t itemCount;
+    bool owned;
+} CollisionWorld;
+
+// what the controller keeps between steps
+typedef struct BeanBody {
+    float fallSpeed; // up is positive
+    bool grounded;
+} BeanBody;
+
+// use the shapes and bvh in a level as they are, nothing is copied
+void CollisionWorldFromLevel(CollisionWorld* world, const Level* level);
+// copy the shapes and build a bvh over them, levelc uses this to make the bvh it writes out
+bool BuildCollisionWorld(CollisionWorld* world, const LevelSphere* spheres, uint32_t sphereCount, const BoundingBox* boxes, uint32_t boxCount);
+void UnloadCollisionWorld(CollisionWorld* world);
+
+// collect the refs (LEVEL_ITEM_BOX | index, or a sphere index) of every shape whose bounds touch area
+// returns how many were found, which can be more than maxItems (only the first maxItems get written)
+uint32_t QueryCollisionWorld(const CollisionWorld* world, BoundingBox area, uint32_t* items, uint32_t maxItems);
+
+// move the bean capsule by delta, sliding along anything it hits instead of stopping dead
+// it's done in steps shorter than the capsule radius so nothing gets tunneled through. grounded can be NULL
+Vector3 SweepBean(const CollisionWorld* world, Vector3 position, Vector3 delta, bool* grounded);
+// one controller step: walk (world space, y ignored) plus gravity, stepping up onto anything under BEAN_STEP_HEIGHT
+Vector3 MoveBean(const CollisionWorld* world, BeanBody* body, Vector3 position, Vector3 walk, float dt);
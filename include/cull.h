@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include "raylib/raylib.h"
+
+// planes point inwards, a point p is inside a plane when dot(normal, p) + distance >= 0
+#define FRUSTUM_PLANES 5 // left, right, down, up, far. the apex sits behind the near plane anyway
+
+typedef struct Frustum {
+    Vector3 normal[FRUSTUM_PLANES];
+    float distance[FRUSTUM_PLANES];
+} Frustum;
+
+// one frustum that holds everything either eye can see, in head space (looking down -z)
+// tangents are the widest fov over both eyes (left and down negative), eyeSpread is how far the furthest eye sits from the head.
+// the apex gets pulled back behind the head until both eyes fit inside
+Frustum StereoFrustum(float tanLeft, float tanRight, float tanDown, float tanUp, float eyeSpread, float farDistance);
+
+// headToWorld is the inverse of the view matrix
+Frustum TransformFrustum(Frustum frustum, Matrix headToWorld);
+
+// test count spheres (positions split into x/y/z arrays) against the frustum, visible[i] gets 1 or 0
+// returns how many are visible
+int CullSpheres(const Frustum* frustum, const float* x, const float* y, const float* z, float radius, int count, unsigned char* visible);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// keeps the frame inside the display period by trading quality for time.
+// cpu time is measured from xrWaitFrame returning to xrEndFrame returning, gpu time with GL_EXT_disjoint_timer_query when it's there.
+// when we run over it first pushes bean LOD down, then starts shrinking the eye buffers, and only at the
+// cheapest levels pulls the cull distance in a bit.
+// needs a GL context, call after InitWindow
+void InitGovernor(void);
+void UnloadGovernor(void);
+
+// displayPeriod is XrFrameState.predictedDisplayPeriod
+void GovernorBeginFrame(int64_t displayPeriod);
+void GovernorBeginGpu(void);
+void GovernorEndGpu(void);
+void GovernorEndFrame(void);
+
+// fraction of the recommended eye buffer size to render at
+float GetGovernorResolutionScale(void);
+// fraction of the normal cull distance, 1 until the cheapest levels
+float GetGovernorCullScale(void);
+// stop changing anything, for comparing against a fixed setup
+void SetGovernorEnabled(bool enabled);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib/raylib.h"
+#include "world.h"
+
+// binary level files, written by tools/levelc and used straight out of the mapped file
+// everything is little endian, plain floats and uint32s, so on the quest and a x86 server the sections are just
+// arrays that get pointed at. no parsing, no per object allocation, loading is one mmap no matter how big it gets
+//
+// layout: LevelHeader, then each section at a 16 byte aligned offset from the start of the file
+// bump LEVEL_VERSION whenever a struct below changes, old files get rejected instead of misread
+
+#define LEVEL_MAGIC 0x4c564542u // "BEVL"
+#define LEVEL_VERSION 1
+#define LEVEL_ALIGN 16
+
+typedef enum {
+    LEVEL_SECTION_VERTICES = 0, // Vector3, the merged world mesh
+    LEVEL_SECTION_INDICES,      // uint32_t
+    LEVEL_SECTION_RANGES,       // WorldRange, one per material
+    LEVEL_SECTION_SPHERES,      // LevelSphere
+    LEVEL_SECTION_BOXES,        // BoundingBox, cubes and planes (planes are flat boxes)
+    LEVEL_SECTION_SPAWNS,       // LevelSpawn
+    LEVEL_SECTION_BVH_NODES,    // LevelBvhNode, over the spheres and boxes
+    LEVEL_SECTION_BVH_ITEMS,    // uint32_t item refs, see LEVEL_ITEM_BOX
+    LEVEL_SECTION_COUNT
+} LevelSectionType;
+
+typedef struct LevelSection {
+    uint32_t offset; // from the start of the file
+    uint32_t size;   // in bytes, count * stride
+    uint32_t count;
+    uint32_t stride; // sizeof the element, checked on load so a struct change can't slip through
+} LevelSection;
+
+typedef struct LevelHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size; // whole file
+    uint32_t sectionCount;
+    LevelSection sections[LEVEL_SECTION_COUNT];
+} LevelHeader;
+
+typedef struct LevelSphere {
+    Vector3 center;
+    float radius;
+} LevelSphere;
+
+typedef struct LevelSpawn {
+    Vector3 position;
+    float yaw; // radians, 0 looks down -z
+} LevelSpawn;
+
+// bvh nodes are stored depth first (see collision.c, which builds and walks them) so the left child is always the next node
+// a leaf has count > 0 and its items are items[firstOrRight .. firstOrRight + count)
+// an inner node has count == 0 and firstOrRight is the index of its right child
+typedef struct LevelBvhNode {
+    Vector3 min;
+    uint32_t firstOrRight;
+    Vector3 max;
+    uint32_t count;
+} LevelBvhNode;
+
+// item refs with this bit set index boxes, otherwise spheres
+#define LEVEL_ITEM_BOX 0x80000000u
+#define LEVEL_ITEM_INDEX(ref) ((ref) & ~LEVEL_ITEM_BOX)
+
+// a loaded level. all pointers go into the mapped file and stay valid until UnloadLevel
+typedef struct Level {
+    const Vector3* vertices;
+    uint32_t vertexCount;
+    const uint32_t* indices;
+    uint32_t indexCount;
+    const WorldRange* ranges;
+    uint32_t rangeCount;
+    const LevelSphere* spheres;
+    uint32_t sphereCount;
+    const BoundingBox* boxes;
+    uint32_t boxCount;
+    const LevelSpawn* spawns;
+    uint32_t spawnCount;
+    const LevelBvhNode* nodes;
+    uint32_t nodeCount;
+    const uint32_t* items;
+    uint32_t itemCount;
+
+    const void* data;
+    size_t size;
+    void* handle; // AAsset on android, NULL when the data was mapped or handed in
+    bool mapped;
+} Level;
+
+// map a level file, on android path is an apk asset name
+bool LoadLevel(Level* level, const char* path);
+// use a level that's already in memory, the memory has to outlive the level and be 4 byte aligned
+bool LoadLevelMemory(Level* level, const void* data, size_t size);
+void UnloadLevel(Level* level);
@@ -3,18 +3,38 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "net/net_constants.h"
+#include "net/net_pose.h"
 // It is ok to include raymath, since raymath doesn't have any conflict with windows.h
 #include "raylib/raymath.h"
 
-void UpdatePlayerList(Vector3 position, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+// velocity is how fast the bean is moving, in meters a second, it's what the dead reckoning guesses from
+void UpdatePlayerList(Vector3 position, Vector3 velocity);
+// the local color, only goes out (reliably, in PlayerAttributes) when it's different from last time
+void UpdatePlayerAttributes(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+// the local head and hands, sent along with the position
+void UpdatePlayerPose(const PlayerPose* pose);
 void UpdateTheBigBean(Vector3 pos, Vector3 tar);
+// move the local bean to its spawn point and face it the way the level says
+void SpawnTheBigBean(int id, Vector3* pos);
+// the server put the local bean somewhere else than where it said it went, it carries on from there
+void CorrectTheBigBean(Vector3 pos);
+// the local bean jumped to a spawn point, the server takes it as a teleport instead of sweeping it there
+void TeleportPlayer(Vector3 position);
 
-void Connect(const char* serverAddress);
+// color and spawn (a level spawn point or SPAWN_ANY) go in the connect itself, so the server can place us and
+// send the world straight back
+void Connect(const char* serverAddress, Color color, int spawn);
+// after a connect failed or the connection dropped, go again with the same address, color and spawn
+void Reconnect();
 void Update(double now, float deltaT);
 void Disconnect();
 bool Connected();
+// a connect is on its way and hasn't been accepted or failed yet
+bool Connecting();
 int GetLocalPlayerId();
 bool GetPlayerPos(int id, Vector3* pos);
+bool GetPlayerPose(int id, PlayerPose* pose);
 
 bool GetPlayerR(int id, unsigned char* r);
 bool GetPlayerG(int id, unsigned char* g);
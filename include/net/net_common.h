@@ -30,6 +30,7 @@
 #pragma once
 
 #include "net/net_constants.h"
+#include "net/net_pose.h"
 
 // ensure we are using winsock2 on windows.
 #if (_WIN32_WINNT < 0x0601)
@@ -61,3 +62,52 @@ uint8_t ReadByte(ENetPacket* packet, size_t* offset);
 int16_t ReadShort(ENetPacket* packet, size_t* offset);
 
 float ReadFloat(ENetPacket* packet, size_t* offset);
+
+uint32_t ReadUInt(ENetPacket* packet, size_t* offset);
+
+// how fast we can send to one peer without queueing up, guessed from what enet measures about it.
+// additive increase while the link looks clean, multiplicative decrease as soon as loss, a rising rtt or enet's own
+// throttle say it's filling up. the send rate and size follow from the bandwidth, so a bad link gets fewer, smaller
+// sends instead of a queue that makes every one of them late
+typedef struct LinkRate {
+	uint32_t bandwidth; // bytes a second
+	double interval; // seconds between sends
+	uint32_t budget; // bytes per send
+	double nextUpdate; // when to look at the peer's stats again
+} LinkRate;
+
+#define LINK_START_BANDWIDTH 16000
+#define LINK_MIN_BANDWIDTH 2000
+#define LINK_MAX_BANDWIDTH 256000
+// how much more to try every update while nothing is going wrong
+#define LINK_BANDWIDTH_STEP 2000
+#define LINK_UPDATE_PERIOD 0.25
+// over this much loss (of ENET_PEER_PACKET_LOSS_SCALE) backs off
+#define LINK_MAX_LOSS (ENET_PEER_PACKET_LOSS_SCALE / 50)
+// rtt this far over the lowest rtt in the throttle interval means packets are sitting in a queue somewhere
+#define LINK_QUEUE_DELAY 30
+// enet's throttle interval, shorter than its 5 seconds so it reacts about as fast as we do
+#define LINK_THROTTLE_INTERVAL 1000
+
+void InitLinkRate(LinkRate* link, double now, int maxRate);
+// sendSize is about how big one full send would be, the rate comes down before the sends get cut short
+void UpdateLinkRate(LinkRate* link, ENetPeer* peer, double now, int minRate, int maxRate, uint32_t sendSize);
+
+Vector3 ReadVelocity(ENetPacket* packet, size_t* offset);
+
+// what a client says about itself when it connects, packed into the 32 bit data of enet_host_connect so the server can
+// accept them, place them and send them the world before they've sent a single packet.
+// 4 bits of version, then a resume flag and the token, or the spawn point they want (3 bits) and their color
+// at 6 bits a channel, close enough to draw them with until the exact one comes in PlayerAttributes
+typedef struct JoinRequest {
+	uint8_t version; // PROTOCOL_VERSION
+	uint32_t resumeToken; // from AcceptPlayer, 0 for a new player
+	int spawn; // a level spawn point, or SPAWN_ANY
+	Color color;
+} JoinRequest;
+
+uint32_t PackJoinRequest(const JoinRequest* request);
+void UnpackJoinRequest(uint32_t data, JoinRequest* request);
+
+// read a pose WritePose wrote, only the parts it carries are changed. returns the parts
+uint8_t ReadPose(ENetPacket* packet, size_t* offset, PlayerPose* pose);
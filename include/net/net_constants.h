@@ -33,10 +33,27 @@
 
 #define MAX_PLAYERS 8
 
+// bumped whenever messages change so old clients get turned away instead of misreading them
+#define PROTOCOL_VERSION 3
+
+// the data a client disconnects with when the player quit, so the server doesn't hold their slot for a resume
+#define DISCONNECT_QUIT 1
+// the data the server disconnects a client with when it speaks a different PROTOCOL_VERSION
+#define DISCONNECT_VERSION 2
+// the data the server disconnects a client with when it asked to resume a slot that's gone, it should join again as a new player
+#define DISCONNECT_STALE_RESUME 3
+
+// resume tokens fit next to the version in the connect data, see JoinRequest
+#define RESUME_TOKEN_MASK 0x07ffffff
+// no spawn point in particular, the server hands them out in turn
+#define SPAWN_ANY -1
+
 // All the different commands that can be sent over the network
 typedef enum
 {
-	// Server -> Client, You have been accepted. Contains the id for the client player to use
+	// Server -> Client, You have been accepted. Contains the id for the client player to use, the resume token to connect
+	// with if the connection drops, whether this picked up where a dropped connection left off (1) or is a new player (0),
+	// and where the server put you, a position and the yaw to face. the world comes in the snapshot right behind it
 	AcceptPlayer = 1,
 
 	// Server -> Client, Add a new player to your simulation, contains the ID of the player and a position
@@ -48,6 +65,18 @@ typedef enum
 	// Server -> Client, Update a player's position in the simulation, contains the ID of the player and a position
 	UpdatePlayer = 4,
 
-	// Client -> Server, Provide an updated location for the client's player, contains the postion to update
+	// Client -> Server, Provide an updated location for the client's player, contains the postion and velocity to update,
+	// a respawn count that goes up every time the client puts itself back at a spawn point, the count of the last
+	// CorrectPosition it got, and the pose.
+	// only sent when the server's dead reckoned guess would be off, on starting or stopping, on respawning, or as a keepalive
 	UpdateInput = 5,
+
+	// Both ways, the things about a player that only change when they change them (color for now), reliable and only sent on change.
+	// Client -> Server has the revision and the attributes, Server -> Client has the ID of the player in front of them.
+	// new attributes only ever get added on the end, so older readers stop early and newer ones read 0 for what wasn't sent
+	PlayerAttributes = 6,
+
+	// Server -> Client, Your last update didn't end up where you said (you went through a wall on your side, or drifted),
+	// contains a correction count and where the server has you. snap there, and put the count in your updates from now on
+	CorrectPosition = 7,
 }NetworkCommands;
\ No newline at end of file
@@ -0,0 +1,54 @@
+// velocities, head and hand poses on the wire, shared by the client and the server
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib/raylib.h"
+
+// everything is in the bean's own frame: the origin is the bean position (its eyes) and the axes are the play space,
+// which turns with the bean. so offsets stay small wherever the bean is in the level and quantize well
+typedef struct PlayerPose {
+	Quaternion rotation; // the bean itself, yaw then pitch
+	Quaternion head; // headset orientation, the bean position already is where the head is
+	Vector3 handPosition[2]; // 0 is left, relative to the head
+	Quaternion handRotation[2];
+	uint8_t tracked; // POSE_LEFT / POSE_RIGHT for hands the headset can see, untracked ones don't get drawn
+} PlayerPose;
+
+// which parts of a pose are in a message, the byte in front of them. the high bits carry PlayerPose.tracked
+#define POSE_ROTATION 0x01
+#define POSE_HEAD 0x02
+#define POSE_LEFT 0x04
+#define POSE_RIGHT 0x08
+#define POSE_ALL 0x0f
+#define POSE_TRACKED_SHIFT 4
+
+// the most WritePose can write, 1 parts byte, 2 rotations, 2 hands of 3 offsets and a rotation
+#define POSE_MAX_SIZE (1 + 4 + 4 + 2 * (6 + 4))
+
+// under these nobody can see the difference, so it isn't worth a byte
+#define POSE_ANGLE_THRESHOLD (1.0f * DEG2RAD)
+#define POSE_POSITION_THRESHOLD 0.005f
+
+// hand offsets are int16 in 1/4096ths of a meter, a quarter millimeter with 8 meters either way
+#define POSE_POSITION_SCALE 4096.0f
+
+// velocities are int16 in centimeters a second each way, +-327 m/s is plenty for a bean
+#define VELOCITY_SCALE 100.0f
+#define VELOCITY_SIZE 6
+void WriteVelocity(uint8_t* buffer, Vector3 velocity);
+// what a velocity reads back as once it's been through WriteVelocity
+Vector3 UnpackVelocity(const uint8_t* buffer);
+
+// smallest three: drop the largest component (it follows from the other three being unit length), 2 bits say which,
+// then 10 bits each for the other three, which can't be bigger than 1/sqrt(2). a quarter of a degree off at worst
+uint32_t PackQuaternion(Quaternion q);
+Quaternion UnpackQuaternion(uint32_t packed);
+
+// identity rotations and no hands, what a bean has before its pose arrives
+void ResetPose(PlayerPose* pose);
+// parts of now that moved far enough from sent to be worth sending
+uint8_t GetPoseChanges(const PlayerPose* sent, const PlayerPose* now);
+// write the parts byte and the parts it names into buffer (POSE_MAX_SIZE at least), returns how many bytes
+size_t WritePose(uint8_t* buffer, const PlayerPose* pose, uint8_t parts);
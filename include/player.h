@@ -1,30 +1,51 @@
+#pragma once
+
 #include "raylib/raylib.h"
 #include "net/net_constants.h"
+#include "collision.h"
 
 // the player id of this client
 //int LocalPlayerId = -1;
 
+// everything the player asked for this tick, from whatever they're holding. movement and turning only ever
+// go through this, so it's also the one input record per tick there is to send or replay
+typedef struct BeanIntent {
+    Vector2 move; // x right, y forward, length at most 1
+    float yaw; // radians to turn this tick, left is positive
+    float pitch; // radians to look up this tick
+} BeanIntent;
+
 typedef struct LocalBean {
-    Transform transform; // player position, rotation, and scale
-    Vector3 target; // player target
-    Vector3 up; // player up? used for rolling i think
-    Vector3 posAdd;
+    Transform transform; // player position, and rotation (yaw then pitch). scale isn't used
+    float yaw; // the angles the rotation is built from, kept so pitch can be clamped and walking ignores it
+    float pitch;
+    Vector3 posAdd; // how far the bean actually moved this tick
+    Vector3 lastTranslation; // position at the tick before, frames get drawn in between the two
+    BeanBody body; // controller state, falling and standing
     BoundingBox beanCollide;
     Color beanColor; // player color
     Vector3 topCap; // start cap for capsule
     Vector3 botCap; // end cap for capsule
-    Camera camera; // camera
+    Camera camera; // only current after GetBeanCamera, anything that moves the bean just marks it dirty
+    bool cameraDirty;
     int cameraMode; // camera mode
 } LocalBean;
 
 //Bean beans[MAX_PLAYERS] = { 0 };
 
 // all of my pride and joy
-void UpdateCameraWithBean(LocalBean* bean);
 Vector3 GetBeanForward(LocalBean* bean);
-Vector3 GetBeanUp(LocalBean* bean);
-Vector3 GetBeanRight(LocalBean* bean);
-void BeanYaw(LocalBean* bean, float angle, bool rotateAroundTarget);
-void BeanPitch(LocalBean* bean, float angle, bool lockView, bool rotateAroundTarget, bool rotateUp);
-void UpdateLocalBean(LocalBean* bean);
+// point the bean at target, the way spawn points and the server hand out directions
+void SetBeanLook(LocalBean* bean, Vector3 target);
+Camera GetBeanCamera(LocalBean* bean);
+
+// mouse look, once per frame since the mouse delta is already a distance and adds up between ticks
+void GatherBeanLook(BeanIntent* intent);
+// held keys and sticks for one tick, added on top of whatever look was gathered
+void GatherBeanIntent(BeanIntent* intent, float dt);
+// one simulation tick: turn, walk and collide, see sim.h
+void UpdateLocalBean(LocalBean* bean, const BeanIntent* intent, const CollisionWorld* world, float dt);
+// where to draw the bean and its camera, blended between the last two ticks
+Vector3 GetBeanDrawPosition(LocalBean* bean, float alpha);
+Camera GetBeanDrawCamera(LocalBean* bean, float alpha);
 void HandleCollision();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+
+// fixed rate simulation clock. movement, collision and network sends run in whole ticks no matter what rate
+// the headset is displaying at, and rendering blends between the last two ticks with GetSimAlpha
+#define SIM_TICK_RATE 60
+#define SIM_TICK (1.0f / SIM_TICK_RATE)
+// after a stall (loading, the headset taken off) don't try to catch up more than this, the rest is dropped
+#define SIM_MAX_TICKS 4
+
+typedef struct SimClock {
+    double last; // wall time of the last advance
+    double accumulator; // time not simulated yet, always under one tick after an advance
+    double time; // simulated time, ticks * SIM_TICK
+    bool started;
+} SimClock;
+
+// how many ticks to run this frame
+static inline int AdvanceSimClock(SimClock* clock, double now)
+{
+    if (!clock->started) {
+        clock->last = now;
+        clock->started = true;
+    }
+
+    clock->accumulator += now - clock->last;
+    clock->last = now;
+    if (clock->accumulator > SIM_MAX_TICKS * (double)SIM_TICK) clock->accumulator = SIM_MAX_TICKS * (double)SIM_TICK;
+
+    int ticks = 0;
+    while (clock->accumulator >= SIM_TICK) {
+        clock->accumulator -= SIM_TICK;
+        clock->time += SIM_TICK;
+        ticks++;
+    }
+    return ticks;
+}
+
+// how far between the previous tick and the latest one the frame being drawn is, 0 to 1
+static inline float GetSimAlpha(const SimClock* clock)
+{
+    return (float)(clock->accumulator * SIM_TICK_RATE);
+}
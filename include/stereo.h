@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include "raylib/raylib.h"
+
+// single pass stereo for our own renderers (rlgl's batch still draws each eye separately)
+// the swapchain is double wide, so instead of multiview every draw is instanced twice and the
+// vertex shader picks the eye from gl_InstanceID and squeezes it into that eye's half.
+// anything spilling over the middle is clipped with GL_EXT_clip_cull_distance, or discarded when that's missing
+// when single pass is off it's the same two viewport passes rlDrawRenderBatch does
+
+typedef struct StereoShader {
+    unsigned int id;
+    int mvpLoc;
+    int eyeLoc;
+} StereoShader;
+
+// needs a GL context, call after InitWindow
+void InitStereo(void);
+void SetStereoSinglePass(bool enabled);
+bool IsStereoSinglePass(void);
+
+// shader sources without a #version line, the stereo prelude gets put in front of both.
+// the vertex shader sets gl_Position = StereoPosition(...) and the fragment shader calls StereoClip() first
+StereoShader LoadStereoShader(const char* vsCode, const char* fsCode);
+void UnloadStereoShader(StereoShader shader);
+
+// flushes rlgl, binds the shader and uploads both eye matrices. returns how many passes to draw
+int BeginStereoDraw(StereoShader shader);
+void SetStereoPass(StereoShader shader, int pass);
+// instance count to draw and divisor to use for per-instance attributes this draw
+int StereoInstances(int instances);
+int StereoInstanceDivisor(void);
+void EndStereoDraw(void);
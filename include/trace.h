@@ -0,0 +1,47 @@
+// low overhead frame tracer
+// zones and counters go into a per-thread ring buffer and can be dumped as Chrome/Perfetto JSON
+// build with -DBEAN_TRACE=0 and every TRACE_* macro compiles away to nothing
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifndef BEAN_TRACE
+#define BEAN_TRACE 1
+#endif
+
+// monotonic clock in nanoseconds, always available so timing code doesn't need the tracer
+static inline uint64_t TraceNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#if BEAN_TRACE
+
+// names must be string literals (or otherwise live forever), only the pointer is stored
+void TraceBegin(const char* name);
+void TraceEnd(const char* name);
+void TraceCounter(const char* name, int64_t value);
+void TraceInstant(const char* name);
+
+// write everything still in the ring buffers out as a Chrome trace event JSON file
+bool TraceDump(const char* path);
+
+#define TRACE_BEGIN(name) TraceBegin(name)
+#define TRACE_END(name) TraceEnd(name)
+#define TRACE_COUNTER(name, value) TraceCounter(name, (int64_t)(value))
+#define TRACE_INSTANT(name) TraceInstant(name)
+#define TRACE_DUMP(path) TraceDump(path)
+
+#else
+
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+#define TRACE_DUMP(path) (false)
+
+#endif
@@ -89,6 +89,7 @@ typedef struct tsoContext_t
 	XrPath posePath[2];
 	XrPath hapticPath[2];
 	XrPath menuClickPath[2];
+	XrPath thumbstickPath[2];
 
 	XrAction grabAction;
 	XrAction triggerAction;
@@ -96,6 +97,7 @@ typedef struct tsoContext_t
 	XrAction poseAction;
 	XrAction vibrateAction;
 	XrAction menuAction;
+	XrAction thumbstickAction;
 	
 	// Swapchain, etc.
 	
@@ -108,6 +110,7 @@ typedef struct tsoContext_t
 	int tsoPrintAll;
 	
 	int tsoSessionReady;
+	int tsoViewConfigsDirty; // Set by tsoHandleLoop when the view configs may have changed and need to be re-enumerated.
 	XrSessionState tsoXRState;
 	tsoRenderLayerFunction_t tsoRenderLayer;
 	int flags;
@@ -664,6 +667,7 @@ int tsoDefaultCreateActions( tsoContext * ctx )
 	tsoInitAction( ctx, XR_ACTION_TYPE_POSE_INPUT, "hand_pose", "Hand Pose", &ctx->poseAction );
 	tsoInitAction( ctx, XR_ACTION_TYPE_VIBRATION_OUTPUT, "vibrate_hand", "Vibrate Hand", &ctx->vibrateAction );
 	tsoInitAction( ctx, XR_ACTION_TYPE_BOOLEAN_INPUT, "quit_session", "Menu Button", &ctx->menuAction );
+	tsoInitAction( ctx, XR_ACTION_TYPE_VECTOR2F_INPUT, "thumbstick", "Thumbstick", &ctx->thumbstickAction );
 
 	xrStringToPath(tsoInstance, "/user/hand/left/input/select/click", &ctx->selectPath[0]);
 	xrStringToPath(tsoInstance, "/user/hand/right/input/select/click", &ctx->selectPath[1]);
@@ -681,6 +685,8 @@ int tsoDefaultCreateActions( tsoContext * ctx )
 	xrStringToPath(tsoInstance, "/user/hand/right/output/haptic", &ctx->hapticPath[1]);
 	xrStringToPath(tsoInstance, "/user/hand/left/input/menu/click", &ctx->menuClickPath[0]);
 	xrStringToPath(tsoInstance, "/user/hand/right/input/menu/click", &ctx->menuClickPath[1]);
+	xrStringToPath(tsoInstance, "/user/hand/left/input/thumbstick", &ctx->thumbstickPath[0]);
+	xrStringToPath(tsoInstance, "/user/hand/right/input/thumbstick", &ctx->thumbstickPath[1]);
 	if (tsoCheck(ctx, result, "xrStringToPath"))
 	{
 		return result;
@@ -729,6 +735,8 @@ int tsoDefaultCreateActions( tsoContext * ctx )
 			{ctx->poseAction, ctx->posePath[1]},
 			{ctx->menuAction, ctx->menuClickPath[0]},
 			//{menuAction, menuClickPath[1]},  // no menu button on right controller?
+			{ctx->thumbstickAction, ctx->thumbstickPath[0]},
+			{ctx->thumbstickAction, ctx->thumbstickPath[1]},
 			{ctx->vibrateAction, ctx->hapticPath[0]},
 			{ctx->vibrateAction, ctx->hapticPath[1]}
 		};
@@ -1024,9 +1032,7 @@ int tsoSyncInput( tsoContext * ctx )
 		return result;
 	}
 
-	// Todo's from original author.
-	// AJT: TODO: xrGetActionStateFloat()
-	// AJT: TODO: xrGetActionStatePose()
+	// action states and hand poses are read by the game, see xr_input.c
 
 	return 0;
 }
@@ -1060,8 +1066,12 @@ int tsoRenderFrame( tsoContext * ctx )
 		return result;
 	}
 
-	// Potentially resize.
-	tsoEnumeratetsoViewConfigs( ctx );
+	// Potentially resize. Only re-query when the runtime told us something changed.
+	if( ctx->tsoViewConfigsDirty )
+	{
+		tsoEnumeratetsoViewConfigs( ctx );
+		ctx->tsoViewConfigsDirty = 0;
+	}
 	
 	// Originally written this way to allow for  || ctx->tsoViewConfigs[0].recommendedImageRectWidth != ctx->tsoSwapchains[0].width  ... But this doesn't work in any current runtimes.
 	if( !ctx->tsoNumViewConfigs || !ctx->tsoSwapchains )
@@ -1197,6 +1207,7 @@ int tsoHandleLoop( tsoContext * ctx )
 					return result;
 				}
 				ctx->tsoSessionReady = 1;
+				ctx->tsoViewConfigsDirty = 1;
 				break;
 			case XR_SESSION_STATE_SYNCHRONIZED:
 				// The application has synced its frame loop with the runtime but is not visible to the user.
@@ -1231,6 +1242,7 @@ int tsoHandleLoop( tsoContext * ctx )
 		case XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING:
 			// The XrEventDataReferenceSpaceChangePending event is sent to the application to notify it that the origin (and perhaps the bounds) of a reference space is changing.
 			TSOPENXR_INFO("XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING\n");
+			ctx->tsoViewConfigsDirty = 1;
 			break;
 		case XR_TYPE_EVENT_DATA_EVENTS_LOST:
 			// Receiving the XrEventDataEventsLost event structure indicates that the event queue overflowed and some events were removed at the position within the queue at which this event was found.
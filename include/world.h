@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib/raylib.h"
+
+// static world geometry. everything added between BeginWorld and BuildWorld gets merged into one vertex and
+// one index buffer, grouped by material, so drawing the world is one draw per material per eye pass no matter
+// how many props there are. a material is just a flat color for now, same as the Draw* calls it replaces
+
+typedef struct WorldRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    Color color;
+} WorldRange;
+
+// merged geometry on the cpu, what BuildWorld uploads and what levelc writes into a level file
+typedef struct WorldMesh {
+    Vector3* vertices;
+    uint32_t vertexCount;
+    uint32_t* indices;
+    uint32_t indexCount;
+    WorldRange* ranges;
+    uint32_t rangeCount;
+} WorldMesh;
+
+// start collecting, throws away anything added before
+void BeginWorld(void);
+void AddWorldPlane(Vector3 center, Vector2 size, Color color);
+void AddWorldCube(Vector3 center, Vector3 size, Color color);
+void AddWorldSphere(Vector3 center, float radius, int rings, int slices, Color color);
+// merge what was added into one mesh and clear the builders, no GL needed so the tools can use it too
+bool MergeWorld(WorldMesh* mesh);
+void FreeWorldMesh(WorldMesh* mesh);
+// merge and upload what was added, needs a GL context
+bool BuildWorld(void);
+
+// upload already merged geometry straight, the ranges have to be sorted by material already
+// nothing is copied on the cpu side unless the batched fallback needs it
+bool LoadWorldBuffers(const Vector3* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const WorldRange* ranges, uint32_t rangeCount);
+
+// draw inside BeginMode3D
+void DrawWorld(void);
+void UnloadWorld(void);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include "tsopenxr.h"
+#include "raylib/raylib.h"
+#include "player.h"
+#include "net/net_pose.h"
+
+// controller state read from the openxr actions tsoDefaultCreateActions makes. sampled once a frame right after
+// xrWaitFrame + xrSyncActions, so it's the newest the runtime has when the ticks for that frame run
+
+// hand 0 is left, 1 is right, the same as TSO.handPath
+typedef struct XrHandInput {
+    bool active; // something is bound to this hand and giving input
+    float grip;
+    float trigger;
+    bool triggerClick;
+    bool menu;
+    Vector2 thumbstick; // x right, y forward, raw with no deadzone
+    XrTime thumbstickChangeTime; // when the runtime last saw the stick move
+
+    // grip pose in stage space, predicted for the display time below
+    bool positionValid;
+    bool orientationValid;
+    Vector3 position;
+    Quaternion orientation;
+    Vector3 linearVelocity; // zero if the runtime didn't give any
+    Vector3 angularVelocity;
+} XrHandInput;
+
+typedef struct XrInput {
+    XrHandInput hands[2];
+    // headset pose in stage space, for the same display time as the hands
+    bool headValid;
+    Vector3 headPosition;
+    Quaternion headOrientation;
+    XrTime displayTime; // predicted display time of the frame this was sampled for, the hand poses are for then
+    double sampleTime; // GetTime() when it was sampled, the same clock sim.h runs on
+} XrInput;
+
+// read every action and locate both hand spaces at displayTime (XrFrameState.predictedDisplayTime)
+int SampleXrInput(tsoContext* ctx, XrInput* input, XrTime displayTime);
+// left stick walks, right stick turns. added into the intent like GatherBeanIntent does for keys and gamepads
+void GatherXrIntent(const XrInput* input, BeanIntent* intent, float dt);
+// head and hands as they get sent to everyone else, see net_pose.h. rotation is left for the caller
+void GetXrPose(const XrInput* input, PlayerPose* pose);
@@ -0,0 +1,124 @@
+#include "level.h"
+#include <string.h>
+
+#if defined(__ANDROID__)
+#include <android_native_app_glue.h>
+#include <android/asset_manager.h>
+
+// defined in rcore_android.c
+extern struct android_app *GetAndroidApp(void);
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const uint32_t strides[LEVEL_SECTION_COUNT] = {
+    sizeof(Vector3),
+    sizeof(uint32_t),
+    sizeof(WorldRange),
+    sizeof(LevelSphere),
+    sizeof(BoundingBox),
+    sizeof(LevelSpawn),
+    sizeof(LevelBvhNode),
+    sizeof(uint32_t)
+};
+
+static const void* Section(const Level* level, const LevelHeader* header, int type, uint32_t* count)
+{
+    *count = header->sections[type].count;
+    return (const uint8_t*)level->data + header->sections[type].offset;
+}
+
+bool LoadLevelMemory(Level* level, const void* data, size_t size)
+{
+    memset(level, 0, sizeof(Level));
+    if (data == NULL || size < sizeof(LevelHeader) || ((uintptr_t)data & 3) != 0) return false;
+
+    // only the header gets checked, the contents are trusted to be whatever levelc wrote
+    const LevelHeader* header = data;
+    if (header->magic != LEVEL_MAGIC || header->version != LEVEL_VERSION) return false;
+    if (header->size > size || header->sectionCount != LEVEL_SECTION_COUNT) return false;
+
+    for (int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        const LevelSection* section = &header->sections[i];
+        if (section->stride != strides[i] || (section->offset & (LEVEL_ALIGN - 1)) != 0) return false;
+        if ((uint64_t)section->count * section->stride != section->size) return false;
+        if ((uint64_t)section->offset + section->size > header->size) return false;
+    }
+
+    level->data = data;
+    level->size = header->size;
+    level->vertices = Section(level, header, LEVEL_SECTION_VERTICES, &level->vertexCount);
+    level->indices = Section(level, header, LEVEL_SECTION_INDICES, &level->indexCount);
+    level->ranges = Section(level, header, LEVEL_SECTION_RANGES, &level->rangeCount);
+    level->spheres = Section(level, header, LEVEL_SECTION_SPHERES, &level->sphereCount);
+    level->boxes = Section(level, header, LEVEL_SECTION_BOXES, &level->boxCount);
+    level->spawns = Section(level, header, LEVEL_SECTION_SPAWNS, &level->spawnCount);
+    level->nodes = Section(level, header, LEVEL_SECTION_BVH_NODES, &level->nodeCount);
+    level->items = Section(level, header, LEVEL_SECTION_BVH_ITEMS, &level->itemCount);
+    return true;
+}
+
+#if defined(__ANDROID__)
+
+bool LoadLevel(Level* level, const char* path)
+{
+    memset(level, 0, sizeof(Level));
+
+    // levels are stored uncompressed in the apk (see the zip line in the Makefile) so the buffer is the asset mapped in place
+    AAsset* asset = AAssetManager_open(GetAndroidApp()->activity->assetManager, path, AASSET_MODE_BUFFER);
+    if (asset == NULL) return false;
+
+    const void* data = AAsset_getBuffer(asset);
+    if (!LoadLevelMemory(level, data, (size_t)AAsset_getLength(asset))) {
+        AAsset_close(asset);
+        return false;
+    }
+    level->handle = asset;
+    return true;
+}
+
+void UnloadLevel(Level* level)
+{
+    if (level->handle != NULL) AAsset_close(level->handle);
+    memset(level, 0, sizeof(Level));
+}
+
+#else
+
+bool LoadLevel(Level* level, const char* path)
+{
+    memset(level, 0, sizeof(Level));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LevelHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    if (!LoadLevelMemory(level, data, (size_t)st.st_size)) {
+        munmap(data, (size_t)st.st_size);
+        return false;
+    }
+    // unmap the whole file, not just what the header covers
+    level->size = (size_t)st.st_size;
+    level->mapped = true;
+    return true;
+}
+
+void UnloadLevel(Level* level)
+{
+    if (level->mapped) munmap((void*)level->data, level->size);
+    memset(level, 0, sizeof(Level));
+}
+
+#endif
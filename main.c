@@ -44,28 +44,82 @@ EGLConfig  egl_config;
 #include "objects.h"
 #include "player.h"
 #include "net/net_client.h"
+#include "trace.h"
+#include "stereo.h"
+#include "cull.h"
+#include "bean_render.h"
+#include "governor.h"
+#include "world.h"
+#include "level.h"
+#include "collision.h"
+#include "sim.h"
+#include "xr_input.h"
 
 // #define MAX_COLUMNS 10
 
 LocalBean bean = { 0 };
 
+// the level stays mapped for the whole run, collision and spawns read straight out of it
+Level level = { 0 };
+CollisionWorld collisionWorld = { 0 };
+
+// gameplay runs on fixed ticks, whatever the headset's refresh rate is
+SimClock simClock = { 0 };
+// what the player asked for since the last tick, used up by the next one
+BeanIntent beanIntent = { 0 };
+XrInput xrInput = { 0 };
+
 #define MAX_INPUT_CHARS 17
 
 typedef enum GameScreen { TITLE, GAMEPLAY } GameScreen;
 
 tsoContext TSO;
 
-bool fbo_set = false;
-unsigned int fbo = 0;
+// one framebuffer per (color image, depth image) pair, built when the swapchains are created
+// so a frame only has to bind the one matching the images it acquired
+unsigned int *swapchainFbos = NULL;
+uint32_t swapchainFboColorCount = 0;
+uint32_t swapchainFboDepthCount = 0;
+// if those couldn't be built, the images get attached to this one every frame instead, like before the cache
+unsigned int fallbackFbo = 0;
 unsigned int active_fbo = 0;
 
 XrFrameState fs;
 XrCompositionLayerProjection layer;
 int layerCount;
 
+// layers submitted on top of the projection layer, cleared after every xrEndFrame
+#define MAX_EXTRA_LAYERS 4
+const XrCompositionLayerBaseHeader * extraLayers[MAX_EXTRA_LAYERS];
+int extraLayerCount = 0;
+
+// the controls box gets its own small swapchain and goes to the compositor as a quad layer
+// so it's only drawn when what it says changes, not twice every frame in the eye buffers
+#define HUD_WIDTH 660
+#define HUD_HEIGHT 170
+XrSwapchain hudSwapchain = XR_NULL_HANDLE;
+XrSwapchainImageOpenGLKHR * hudSwapchainImages;
+uint32_t hudSwapchainLength = 0;
+unsigned int * hudFbos;
+XrCompositionLayerQuad hudLayer;
+int hudContent = -1; // what's in the swapchain right now, -1 is nothing yet
+
 XrSpace view_space;
 
+// everything submitted to xrEndFrame lives here and is only rebuilt when the swapchains or view count change
+XrView *frameViews;
 XrCompositionLayerProjectionView *projectionLayerViews;
+uint32_t frameLayerViewCount = 0;
+bool frameLayersBuilt = false;
+
+// both eyes' view volume in head space, rebuilt every frame from the located views
+Frustum headFrustum;
+
+// nothing past this gets drawn
+#define CULL_DISTANCE 150.0f
+// seconds between tries to get back in after the connection drops, doubling up to the max
+#define RECONNECT_MIN_DELAY 0.5
+#define RECONNECT_MAX_DELAY 8.0
 
 typedef struct
 {
@@ -116,6 +170,26 @@ int depthAcquireSwapchain( tsoContext * ctx, int swapchainNumber, uint32_t * swa
 	return 0;
 }
 
+int depthDestroySwapchains( tsoContext * ctx )
+{
+	int i;
+	XrResult result;
+	if( !depthSwapchains ) return 0;
+	for( i = 0; i < numDepthSwapchainsPerFrame; i++ )
+	{
+		result = xrDestroySwapchain( depthSwapchains[i].handle );
+		if( tsoCheck(ctx, result, "xrDestroySwapchain") ) return result;
+		free( depthSwapchainImages[i] );
+	}
+	free( depthSwapchains );
+	free( depthSwapchainImages );
+	free( depthSwapchainLengths );
+	depthSwapchains = 0;
+	depthSwapchainImages = 0;
+	depthSwapchainLengths = 0;
+	return 0;
+}
+
 int depthCreateSwapchains(tsoContext * ctx) {
     XrSession tsoSession = ctx->tsoSession;
 	XrViewConfigurationView * tsoViewConfigs = ctx->tsoViewConfigs;
@@ -166,13 +240,13 @@ int depthCreateSwapchains(tsoContext * ctx) {
 
 	if( *tsoSwapchains )
 	{
-		tsoDestroySwapchains( ctx );
+		depthDestroySwapchains( ctx );
 	}
 
 	// For now we just pick the default one.
 	int64_t swapchainFormatToUse = swapchainFormats[selfmt];
 
-	int numSwapchainsPerFrame = ctx->numSwapchainsPerFrame = (ctx->flags & TSO_DOUBLEWIDE)?1:tsoNumViewConfigs;
+	int numSwapchainsPerFrame = numDepthSwapchainsPerFrame = (ctx->flags & TSO_DOUBLEWIDE)?1:tsoNumViewConfigs;
 
 	uint32_t swapchain_width = 0;
 	for (uint32_t i = 0; i < tsoNumViewConfigs; i++) {
@@ -291,16 +365,100 @@ static Matrix xr_matrix(const XrPosef pose)
 	return MatrixMultiply(rotation, translation);
 }
 
-int BeginDrawingXR(tsoContext * ctx)
+static void DestroySwapchainFramebuffers(void)
+{
+    // not rlUnloadFramebuffer, that also deletes the attached depth texture and those belong to the runtime
+    if(fallbackFbo != 0) {
+        glDeleteFramebuffers(1, &fallbackFbo);
+        fallbackFbo = 0;
+    }
+
+    if(swapchainFbos == NULL) return;
+
+    glDeleteFramebuffers(swapchainFboColorCount * swapchainFboDepthCount, swapchainFbos);
+    free(swapchainFbos);
+    swapchainFbos = NULL;
+    swapchainFboColorCount = 0;
+    swapchainFboDepthCount = 0;
+}
+
+// attach and validate every color/depth image pair up front, checking completeness here instead of every frame
+static int CreateSwapchainFramebuffers(tsoContext * ctx)
 {
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "Begin BeginDrawingXR");
-    if(!fbo_set) {
-        fbo = rlLoadFramebuffer(0, 0);
+    DestroySwapchainFramebuffers();
+
+    uint32_t colorCount = ctx->tsoSwapchainLengths[0];
+    uint32_t depthCount = depthSwapchainLengths[0];
+    swapchainFbos = calloc(colorCount * depthCount, sizeof(unsigned int));
+    swapchainFboColorCount = colorCount;
+    swapchainFboDepthCount = depthCount;
+
+    for(uint32_t c = 0; c < colorCount; c++) {
+        for(uint32_t d = 0; d < depthCount; d++) {
+            unsigned int id = rlLoadFramebuffer(0, 0);
+            rlFramebufferAttach(id, ctx->tsoSwapchainImages[0][c].image, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+            rlFramebufferAttach(id, depthSwapchainImages[0][d].image, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+            swapchainFbos[c * depthCount + d] = id;
+            if(!rlFramebufferComplete(id)) {
+                // the ones not made yet are still 0, glDeleteFramebuffers skips those
+                __android_log_print(ANDROID_LOG_WARN, "beangamevr", "Swapchain framebuffer %u/%u is incomplete, attaching every frame instead", c, d);
+                DestroySwapchainFramebuffers();
+                return 1;
+            }
+        }
     }
 
+    TRACE_COUNTER("swapchain fbos", colorCount * depthCount);
+    return 0;
+}
+
+// (re)build the views and composition layer structs that get handed to the runtime every frame
+// only called when the swapchains or the view count change, per frame we just patch in the new poses
+static void CreateFrameLayers(tsoContext * ctx)
+{
+	uint32_t viewCount = ctx->tsoNumViewConfigs;
+
+	frameViews = realloc( frameViews, viewCount * sizeof( XrView ) );
+	projectionLayerViews = realloc( projectionLayerViews, viewCount * sizeof( XrCompositionLayerProjectionView ) );
+	depthView = realloc( depthView, viewCount * sizeof( XrCompositionLayerDepthInfoKHR ) );
+	memset( projectionLayerViews, 0, sizeof( XrCompositionLayerProjectionView ) * viewCount );
+	memset( depthView, 0, sizeof( XrCompositionLayerDepthInfoKHR ) * viewCount );
+
+	for( uint32_t i = 0; i < viewCount; i++ )
+	{
+		frameViews[i].type = XR_TYPE_VIEW;
+		frameViews[i].next = NULL;
+
+		// Each view has a separate swapchain which is acquired, rendered to, and released.
+		XrCompositionLayerProjectionView * layerView = projectionLayerViews + i;
+		layerView->type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+		layerView->next = &depthView[i];
+		layerView->subImage.swapchain = ctx->tsoSwapchains->handle;
+		layerView->subImage.imageRect.offset.x = ( ctx->flags & TSO_DOUBLEWIDE ) ? i * ctx->tsoViewConfigs[i].recommendedImageRectWidth : 0;
+		layerView->subImage.imageRect.offset.y = 0;
+		layerView->subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
+		layerView->subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
+		layerView->subImage.imageArrayIndex = 0;
+
+		depthView[i].type = XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR;
+		depthView[i].minDepth = 0.f;
+		depthView[i].maxDepth = 1.f;
+		depthView[i].nearZ = (float)RL_CULL_DISTANCE_NEAR;
+		depthView[i].farZ = (float)RL_CULL_DISTANCE_FAR;
+		depthView[i].subImage = layerView->subImage;
+		depthView[i].subImage.swapchain = depthSwapchains->handle;
+	}
+
+	frameLayerViewCount = viewCount;
+	frameLayersBuilt = true;
+	TRACE_INSTANT("frame layers rebuilt");
+}
+
+// first thing in a frame, before input gets read. once this returns the runtime has told us when the frame will be
+// shown, so sampling input and running the ticks after it means the newest input goes into what gets displayed
+int WaitFrameXR(tsoContext * ctx)
+{
     XrSession tsoSession = ctx->tsoSession;
-	int tsoNumViewConfigs = ctx->tsoNumViewConfigs;
-	XrSpace tsoStageSpace = ctx->tsoStageSpace;
 
 	fs.type = XR_TYPE_FRAME_STATE;
 	fs.next = NULL;
@@ -309,43 +467,65 @@ int BeginDrawingXR(tsoContext * ctx)
 	fwi.type = XR_TYPE_FRAME_WAIT_INFO;
 	fwi.next = NULL;
 
+	TRACE_BEGIN("xrWaitFrame");
 	XrResult result = xrWaitFrame(tsoSession, &fwi, &fs);
+	TRACE_END("xrWaitFrame");
 	if (tsoCheck(ctx, result, "xrWaitFrame"))
 	{
 		return result;
 	}
+	GovernorBeginFrame(fs.predictedDisplayPeriod);
+	ctx->tsoPredictedDisplayTime = fs.predictedDisplayTime;
+
+	return 0;
+}
+
+int BeginDrawingXR(tsoContext * ctx)
+{
+    XrSession tsoSession = ctx->tsoSession;
+	int tsoNumViewConfigs = ctx->tsoNumViewConfigs;
+	XrSpace tsoStageSpace = ctx->tsoStageSpace;
+	XrResult result;
 
 	XrFrameBeginInfo fbi;
 	fbi.type = XR_TYPE_FRAME_BEGIN_INFO;
 	fbi.next = NULL;
+	TRACE_BEGIN("xrBeginFrame");
 	result = xrBeginFrame(tsoSession, &fbi);
+	TRACE_END("xrBeginFrame");
 	if (tsoCheck(ctx, result, "xrBeginFrame"))
 	{
 		return result;
 	}
 
-	// Potentially resize.
-	tsoEnumeratetsoViewConfigs( ctx );
+	// Potentially resize. Only re-query when the runtime told us something changed.
+	if( ctx->tsoViewConfigsDirty )
+	{
+		tsoEnumeratetsoViewConfigs( ctx );
+		ctx->tsoViewConfigsDirty = 0;
+	}
 	
 	// Originally written this way to allow for  || ctx->tsoViewConfigs[0].recommendedImageRectWidth != ctx->tsoSwapchains[0].width  ... But this doesn't work in any current runtimes.
 	if( !ctx->tsoNumViewConfigs || !ctx->tsoSwapchains )
 	{
 		if ( ( result = tsoCreateSwapchains( ctx ) ) ) return result;
+		frameLayersBuilt = false;
     }
 
     if( !ctx->tsoNumViewConfigs || !depthSwapchains )
 	{
 		if ( ( result = depthCreateSwapchains( ctx ) ) ) return result;
+		frameLayersBuilt = false;
     }
 
-    layerCount = 0;
+    if( !frameLayersBuilt || frameLayerViewCount != ctx->tsoNumViewConfigs )
+    {
+        // on failure swapchainFbos stays NULL and frames use fallbackFbo until the swapchains get rebuilt
+        CreateSwapchainFramebuffers( ctx );
+        CreateFrameLayers( ctx );
+    }
 
-	XrView * views = alloca( sizeof( XrView) * tsoNumViewConfigs );
-	for (size_t i = 0; i < tsoNumViewConfigs; i++)
-	{
-		views[i].type = XR_TYPE_VIEW;
-		views[i].next = NULL;
-	}
+    layerCount = 0;
 	
 	uint32_t viewCountOutput;
 	XrViewState viewState = { XR_TYPE_VIEW_STATE };
@@ -353,9 +533,9 @@ int BeginDrawingXR(tsoContext * ctx)
 	XrViewLocateInfo vli;
 	vli.type = XR_TYPE_VIEW_LOCATE_INFO;
 	vli.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
-	ctx->tsoPredictedDisplayTime = vli.displayTime = fs.predictedDisplayTime;
+	vli.displayTime = fs.predictedDisplayTime;
 	vli.space = tsoStageSpace;
-	result = xrLocateViews( tsoSession, &vli, &viewState, tsoNumViewConfigs, &viewCountOutput, views );
+	result = xrLocateViews( tsoSession, &vli, &viewState, frameLayerViewCount, &viewCountOutput, frameViews );
 	if (tsoCheck(ctx, result, "xrLocateViews"))
 	{
 		return result;
@@ -370,69 +550,37 @@ int BeginDrawingXR(tsoContext * ctx)
 		return result;
 	}
 
-	projectionLayerViews = malloc( viewCountOutput * sizeof( XrCompositionLayerProjectionView ) );
-	memset( projectionLayerViews, 0, sizeof( XrCompositionLayerProjectionView ) * viewCountOutput );
-
+	// everything else in the layer views was filled in by CreateFrameLayers
 	int i;
-	int viewCounts = (ctx->flags & TSO_DOUBLEWIDE)?1:viewCountOutput;
 	for( i = 0; i < viewCountOutput; i++ )
 	{
-		// Each view has a separate swapchain which is acquired, rendered to, and released.
-		XrCompositionLayerProjectionView * layerView = projectionLayerViews + i;
-		layerView->type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
-		layerView->pose = views[i].pose;
-		layerView->fov = views[i].fov;
-		
-		if( ctx->flags & TSO_DOUBLEWIDE )
-		{
-			layerView->subImage.swapchain = ctx->tsoSwapchains->handle;
-			layerView->subImage.imageRect.offset.x = i * ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			layerView->subImage.imageRect.offset.y = 0;
-			layerView->subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			layerView->subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
-			layerView->subImage.imageArrayIndex = 0;
-		}
-		else
-		{
-			layerView->subImage.swapchain = ctx->tsoSwapchains->handle;
-			layerView->subImage.imageRect.offset.x = 0;
-			layerView->subImage.imageRect.offset.y = 0;
-			layerView->subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			layerView->subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
-			layerView->subImage.imageArrayIndex = 0;
-		}
+		projectionLayerViews[i].pose = frameViews[i].pose;
+		projectionLayerViews[i].fov = frameViews[i].fov;
 	}
 
-    depthView = malloc( viewCountOutput * sizeof( XrCompositionLayerDepthInfoKHR ) );
-    memset( depthView, 0, sizeof( XrCompositionLayerDepthInfoKHR ) * viewCountOutput );
-    for( i = 0; i < viewCountOutput; i++ )
+	// widest fov on each side over both eyes, the apex gets pulled back to cover the eye offsets
+	float tanLeft = 0.0f, tanRight = 0.0f, tanDown = 0.0f, tanUp = 0.0f, eyeSpread = 0.0f;
+	Vector3 headPosition = { view_location.pose.position.x, view_location.pose.position.y, view_location.pose.position.z };
+	for( i = 0; i < viewCountOutput; i++ )
 	{
-		depthView[i].type = XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR;
-        depthView[i].minDepth = 0.f;
-        depthView[i].maxDepth = 1.f;
-        depthView[i].nearZ = (float)RL_CULL_DISTANCE_NEAR;
-        depthView[i].farZ = (float)RL_CULL_DISTANCE_FAR;
-		
-		if( ctx->flags & TSO_DOUBLEWIDE )
-		{
-			depthView[i].subImage.swapchain = depthSwapchains->handle;
-			depthView[i].subImage.imageRect.offset.x = i * ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			depthView[i].subImage.imageRect.offset.y = 0;
-			depthView[i].subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			depthView[i].subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
-			depthView[i].subImage.imageArrayIndex = 0;
-		}
-		else
-		{
-			depthView[i].subImage.swapchain = depthSwapchains->handle;
-			depthView[i].subImage.imageRect.offset.x = 0;
-			depthView[i].subImage.imageRect.offset.y = 0;
-			depthView[i].subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-			depthView[i].subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
-			depthView[i].subImage.imageArrayIndex = 0;
-		}
+		tanLeft = fminf(tanLeft, tanf(frameViews[i].fov.angleLeft));
+		tanRight = fmaxf(tanRight, tanf(frameViews[i].fov.angleRight));
+		tanDown = fminf(tanDown, tanf(frameViews[i].fov.angleDown));
+		tanUp = fmaxf(tanUp, tanf(frameViews[i].fov.angleUp));
+		Vector3 eyePosition = { frameViews[i].pose.position.x, frameViews[i].pose.position.y, frameViews[i].pose.position.z };
+		eyeSpread = fmaxf(eyeSpread, Vector3Distance(eyePosition, headPosition));
+	}
+	headFrustum = StereoFrustum(tanLeft, tanRight, tanDown, tanUp, eyeSpread, CULL_DISTANCE * GetGovernorCullScale());
 
-        projectionLayerViews[i].next = &depthView[i];
+	// the governor can have us rendering into less than the whole swapchain image, both layers need the same rect
+	float resolutionScale = GetGovernorResolutionScale();
+	int eyeWidth = (int)(ctx->tsoViewConfigs[0].recommendedImageRectWidth * resolutionScale);
+	int eyeHeight = (int)(ctx->tsoViewConfigs[0].recommendedImageRectHeight * resolutionScale);
+	for( i = 0; i < viewCountOutput; i++ )
+	{
+		XrRect2Di rect = { { ( ctx->flags & TSO_DOUBLEWIDE ) ? i * eyeWidth : 0, 0 }, { eyeWidth, eyeHeight } };
+		projectionLayerViews[i].subImage.imageRect = rect;
+		depthView[i].subImage.imageRect = rect;
 	}
 
     layer = (XrCompositionLayerProjection){
@@ -442,37 +590,36 @@ int BeginDrawingXR(tsoContext * ctx)
         .space = tsoStageSpace,
     };
 
-    if(!fbo_set) {
-        uint32_t swapchain_width = 0;
-        for( i = 0; i < viewCountOutput; i++ ) {
-            swapchain_width += ctx->tsoViewConfigs[i].recommendedImageRectWidth;
-        }
-        fbo = rlLoadFramebuffer(swapchain_width, ctx->tsoViewConfigs[0].recommendedImageRectHeight);
-        fbo_set = true;
-    }
-		
 	// We only support up to 1 layer.
 	if (fs.shouldRender == XR_TRUE && XR_UNQUALIFIED_SUCCESS(result))
 	{
 		uint32_t swapchainImageIndex;
         uint32_t depthSwapchainImageIndex;
 
+        TRACE_BEGIN("swapchain acquire");
         tsoAcquireSwapchain( ctx, 0, &swapchainImageIndex );
         depthAcquireSwapchain( ctx, 0, &depthSwapchainImageIndex );
+        TRACE_END("swapchain acquire");
 
         const XrSwapchainImageOpenGLKHR * swapchainImage = &ctx->tsoSwapchainImages[0][swapchainImageIndex];
         const XrSwapchainImageOpenGLKHR * depthSwapchainImage = &depthSwapchainImages[0][depthSwapchainImageIndex];
 
         uint32_t colorTexture = swapchainImage->image;
         uint32_t depthTexture = depthSwapchainImage->image;
+        unsigned int fbo = 0;
+        if(swapchainFbos != NULL) {
+            fbo = swapchainFbos[swapchainImageIndex * swapchainFboDepthCount + depthSwapchainImageIndex];
+        } else {
+            if(fallbackFbo == 0) fallbackFbo = rlLoadFramebuffer(0, 0);
+            rlFramebufferAttach(fallbackFbo, colorTexture, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+            rlFramebufferAttach(fallbackFbo, depthTexture, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+            if(!rlFramebufferComplete(fallbackFbo)) return 1;
+            fbo = fallbackFbo;
+        }
 
-        int render_texture_width = ctx->tsoViewConfigs[0].recommendedImageRectWidth * 2;
-        int render_texture_height = ctx->tsoViewConfigs[0].recommendedImageRectHeight;
-
-        rlFramebufferAttach(fbo, colorTexture, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
-        rlFramebufferAttach(fbo, depthTexture, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
-
-        if(!rlFramebufferComplete(fbo)) return 1;
+        // only the scaled part of the image gets drawn to, rlgl splits this width between the eyes
+        int render_texture_width = eyeWidth * 2;
+        int render_texture_height = eyeHeight;
 
         RenderTexture2D render_texture = (RenderTexture2D){
             fbo,
@@ -493,17 +640,18 @@ int BeginDrawingXR(tsoContext * ctx)
         };
 
         BeginTextureMode(render_texture);
+        GovernorBeginGpu();
 
         rlEnableStereoRender();
 
         // doesnt work unless swapped
-        Matrix proj_left = xr_projection_matrix(views[0].fov);
-        Matrix proj_right = xr_projection_matrix(views[1].fov);
+        Matrix proj_left = xr_projection_matrix(frameViews[0].fov);
+        Matrix proj_right = xr_projection_matrix(frameViews[1].fov);
         rlSetMatrixProjectionStereo(proj_right, proj_left);
 
         const Matrix view_matrix = MatrixInvert(xr_matrix(view_location.pose));
-        const Matrix view_offset_left = MatrixMultiply(xr_matrix(views[0].pose), view_matrix);
-        const Matrix view_offset_right = MatrixMultiply(xr_matrix(views[1].pose), view_matrix);
+        const Matrix view_offset_left = MatrixMultiply(xr_matrix(frameViews[0].pose), view_matrix);
+        const Matrix view_offset_right = MatrixMultiply(xr_matrix(frameViews[1].pose), view_matrix);
         rlSetMatrixViewOffsetStereo(view_offset_right, view_offset_left);
 
         layer.viewCount = viewCountOutput;
@@ -511,17 +659,29 @@ int BeginDrawingXR(tsoContext * ctx)
 		layerCount = 1;
     }
 
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "End BeginDrawingXR");
-
 	return 0;
 }
 
+// queue a layer to go on top of the projection layer this frame, the struct has to live until EndDrawingXR
+void SubmitLayerXR(const XrCompositionLayerBaseHeader * extraLayer)
+{
+    if (extraLayerCount < MAX_EXTRA_LAYERS) extraLayers[extraLayerCount++] = extraLayer;
+}
+
 int EndDrawingXR(tsoContext * ctx) {
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "Begin EndDrawingXR");
 
     XrSession tsoSession = ctx->tsoSession;
-    const XrCompositionLayerBaseHeader * layers[1] = { (XrCompositionLayerBaseHeader *)&layer };
 
+    // projection layer first, anything else goes over it in the order it was submitted
+    const XrCompositionLayerBaseHeader * layers[1 + MAX_EXTRA_LAYERS];
+    uint32_t submitLayerCount = 0;
+    if (layerCount) {
+        layers[submitLayerCount++] = (XrCompositionLayerBaseHeader *)&layer;
+        for (int i = 0; i < extraLayerCount; i++) layers[submitLayerCount++] = extraLayers[i];
+    }
+    extraLayerCount = 0;
+
+    GovernorEndGpu();
     EndTextureMode();
     active_fbo = 0;
 
@@ -533,21 +693,179 @@ int EndDrawingXR(tsoContext * ctx) {
     XrFrameEndInfo fei = { XR_TYPE_FRAME_END_INFO };
 	fei.displayTime = fs.predictedDisplayTime;
 	fei.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
-	fei.layerCount = layerCount;
+	fei.layerCount = submitLayerCount;
 	fei.layers = layers;
 
+	TRACE_BEGIN("xrEndFrame");
 	XrResult result = xrEndFrame(tsoSession, &fei);
+	TRACE_END("xrEndFrame");
+
+	// after xrEndFrame so the submit counts too
+	GovernorEndFrame();
 	if (tsoCheck(ctx, result, "xrEndFrame"))
 	{
 		return result;
 	}
 
-    free(projectionLayerViews);
-    free(depthView);
+	return 0;
+}
 
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "End EndDrawingXR");
+static int CreateHudSwapchain(tsoContext * ctx)
+{
+    uint32_t formatCount;
+    XrResult result = xrEnumerateSwapchainFormats(ctx->tsoSession, 0, &formatCount, NULL);
+    if (tsoCheck(ctx, result, "xrEnumerateSwapchainFormats")) return result;
+    int64_t * formats = alloca(formatCount * sizeof(int64_t));
+    result = xrEnumerateSwapchainFormats(ctx->tsoSession, formatCount, &formatCount, formats);
+    if (tsoCheck(ctx, result, "xrEnumerateSwapchainFormats")) return result;
+
+    // same as the eye buffers if we can, plain RGBA otherwise
+    int64_t format = formats[0];
+    for (uint32_t i = 0; i < formatCount; i++) {
+        if (formats[i] == GL_RGBA8) format = formats[i];
+    }
+    for (uint32_t i = 0; i < formatCount; i++) {
+        if (formats[i] == GL_SRGB8_ALPHA8) format = formats[i];
+    }
 
-	return 0;
+    XrSwapchainCreateInfo sci = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+    sci.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+    sci.format = format;
+    sci.sampleCount = 1;
+    sci.width = HUD_WIDTH;
+    sci.height = HUD_HEIGHT;
+    sci.faceCount = 1;
+    sci.arraySize = 1;
+    sci.mipCount = 1;
+    result = xrCreateSwapchain(ctx->tsoSession, &sci, &hudSwapchain);
+    if (tsoCheck(ctx, result, "xrCreateSwapchain [hud]")) return result;
+
+    result = xrEnumerateSwapchainImages(hudSwapchain, 0, &hudSwapchainLength, NULL);
+    if (tsoCheck(ctx, result, "xrEnumerateSwapchainImages [hud]")) return result;
+    hudSwapchainImages = calloc(hudSwapchainLength, sizeof(XrSwapchainImageOpenGLKHR));
+    for (uint32_t i = 0; i < hudSwapchainLength; i++) {
+#ifdef ANDROID
+        hudSwapchainImages[i].type = XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR;
+#else
+        hudSwapchainImages[i].type = XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR;
+#endif
+    }
+    result = xrEnumerateSwapchainImages(hudSwapchain, hudSwapchainLength, &hudSwapchainLength, (XrSwapchainImageBaseHeader *)hudSwapchainImages);
+    if (tsoCheck(ctx, result, "xrEnumerateSwapchainImages [hud]")) return result;
+
+    // color only, no depth needed for a flat box of text
+    hudFbos = calloc(hudSwapchainLength, sizeof(unsigned int));
+    for (uint32_t i = 0; i < hudSwapchainLength; i++) {
+        hudFbos[i] = rlLoadFramebuffer(0, 0);
+        rlFramebufferAttach(hudFbos[i], hudSwapchainImages[i].image, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+        if (!rlFramebufferComplete(hudFbos[i])) return 1;
+    }
+
+    // head locked, up and to the left about where the box used to be in the eye buffers
+    hudLayer = (XrCompositionLayerQuad){
+        .type = XR_TYPE_COMPOSITION_LAYER_QUAD,
+        .next = NULL,
+        .layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT | XR_COMPOSITION_LAYER_UNPREMULTIPLIED_ALPHA_BIT,
+        .space = ctx->tsoViewSpace,
+        .eyeVisibility = XR_EYE_VISIBILITY_BOTH,
+        .subImage = {
+            .swapchain = hudSwapchain,
+            .imageRect = { { 0, 0 }, { HUD_WIDTH, HUD_HEIGHT } },
+            .imageArrayIndex = 0,
+        },
+        .pose = { { 0.0f, 0.0f, 0.0f, 1.0f }, { -0.3f, 0.2f, -1.0f } },
+        .size = { 0.33f, 0.085f },
+    };
+
+    hudContent = -1;
+    return 0;
+}
+
+static void DestroyHudSwapchain(void)
+{
+    if (hudSwapchain == XR_NULL_HANDLE) return;
+
+    // not rlUnloadFramebuffer, the images belong to the runtime
+    glDeleteFramebuffers(hudSwapchainLength, hudFbos);
+    free(hudFbos);
+    free(hudSwapchainImages);
+    xrDestroySwapchain(hudSwapchain);
+    hudSwapchain = XR_NULL_HANDLE;
+    hudSwapchainLength = 0;
+}
+
+static void DrawHud(bool gamepad)
+{
+    // the box was laid out for a 330x85 corner of the screen, draw it at twice that so the text stays sharp
+    BeginMode2D((Camera2D){ .offset = { 0, 0 }, .target = { 5, 5 }, .rotation = 0.0f, .zoom = 2.0f });
+    DrawRectangle(5, 5, 330, 85, RED);
+    DrawRectangleLines(5, 5, 330, 85, BLUE);
+    DrawText("Player controls:", 15, 15, 10, BLACK);
+    if(gamepad) {
+        DrawText("- Move: Left Analog Stick", 15, 30, 10, BLACK);
+        DrawText("- Look around: Right Analog Stick", 15, 45, 10, BLACK);
+        DrawText("- Camera mode: Left Trigger, Right Trigger", 15, 60, 10, BLACK);
+        DrawText("- Generate a new color: Left Thumb", 15, 75, 10, BLACK);
+    } else {
+        DrawText("- Move keys: W, A, S, D, Space, Left-Ctrl", 15, 30, 10, BLACK);
+        DrawText("- Look around: arrow keys or mouse", 15, 45, 10, BLACK);
+        DrawText("- Camera mode keys: 1, 2", 15, 60, 10, BLACK);
+        DrawText("- Generate a new color: 3", 15, 75, 10, BLACK);
+    }
+    EndMode2D();
+}
+
+// redraws the hud swapchain if the content changed and queues its layer for this frame
+// call before BeginDrawingXR, it can't be drawn while the eye buffers are bound
+static void UpdateHudXR(tsoContext * ctx, bool gamepad)
+{
+    if (!ctx->tsoSessionReady) return;
+    if (hudSwapchain == XR_NULL_HANDLE && CreateHudSwapchain(ctx)) {
+        DestroyHudSwapchain();
+        return;
+    }
+
+    if (hudContent != (int)gamepad) {
+        TRACE_BEGIN("hud redraw");
+
+        uint32_t index;
+        XrSwapchainImageAcquireInfo ai = { XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+        if (tsoCheck(ctx, xrAcquireSwapchainImage(hudSwapchain, &ai, &index), "xrAcquireSwapchainImage [hud]")) return;
+        XrSwapchainImageWaitInfo wi = { XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+        wi.timeout = XR_INFINITE_DURATION;
+        if (tsoCheck(ctx, xrWaitSwapchainImage(hudSwapchain, &wi), "xrWaitSwapchainImage [hud]")) return;
+
+        BeginTextureMode((RenderTexture2D){
+            hudFbos[index],
+            (Texture2D){ hudSwapchainImages[index].image, HUD_WIDTH, HUD_HEIGHT, 1, -1 },
+            (Texture2D){ 0 }
+        });
+        ClearBackground(BLANK);
+        DrawHud(gamepad);
+        EndTextureMode();
+
+        XrSwapchainImageReleaseInfo ri = { XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+        tsoCheck(ctx, xrReleaseSwapchainImage(hudSwapchain, &ri), "xrReleaseSwapchainImage [hud]");
+
+        hudContent = gamepad;
+        TRACE_END("hud redraw");
+    }
+
+    // the compositor keeps showing the last released image, so nothing to do on frames where it didn't change
+    SubmitLayerXR((XrCompositionLayerBaseHeader *)&hudLayer);
+}
+
+// hands go where the remote player holds them, turned with their bean (see net_pose.h)
+static void PushPlayerHands(Vector3 position, const PlayerPose * pose, Color color)
+{
+    if (!pose->tracked) return;
+
+    Vector3 forward = Vector3RotateByQuaternion((Vector3){ 0.0f, 0.0f, -1.0f }, pose->rotation);
+    Quaternion yaw = QuaternionFromAxisAngle((Vector3){ 0.0f, 1.0f, 0.0f }, atan2f(-forward.x, -forward.z));
+    for (int i = 0; i < 2; i++) {
+        if (!(pose->tracked & (POSE_LEFT << i))) continue;
+        PushHand(Vector3Add(position, Vector3RotateByQuaternion(pose->handPosition[i], yaw)), color);
+    }
 }
 
 // defined in rcore_android.c, needed for tsOpenXR
@@ -572,6 +890,25 @@ int main(int argc, char *argv[])
 
     __android_log_print(ANDROID_LOG_INFO, "beangamevr", "Window initialized");
 
+    InitStereo();
+    InitBeanRenderer();
+    InitGovernor();
+
+    // static world comes out of the level file already merged, so it goes to the gpu without touching it
+    // if the level is missing fall back to building the old ground plane here
+    if (LoadLevel(&level, "arena.level")) {
+        TraceLog(LOG_INFO, "LEVEL: Mapped arena.level, %u vertices, %u collision shapes, %u spawns", level.vertexCount, level.sphereCount + level.boxCount, level.spawnCount);
+        LoadWorldBuffers(level.vertices, level.vertexCount, level.indices, level.indexCount, level.ranges, level.rangeCount);
+        CollisionWorldFromLevel(&collisionWorld, &level);
+    } else {
+        TraceLog(LOG_WARNING, "LEVEL: Couldn't load arena.level, using the built in ground");
+        BeginWorld();
+        AddWorldPlane((Vector3){ 0.0f, 0.0f, 0.0f }, (Vector2){ 32.0f, 32.0f }, LIGHTGRAY); // ground
+        BuildWorld();
+        BoundingBox ground = { { -16.0f, 0.0f, -16.0f }, { 16.0f, 0.0f, 16.0f } };
+        BuildCollisionWorld(&collisionWorld, NULL, 0, &ground, 1);
+    }
+
     char serverIp[MAX_INPUT_CHARS + 1] = "172.233.208.111\0";
     int letterCount = 15;
     
@@ -583,12 +920,12 @@ int main(int argc, char *argv[])
     // Define the camera to look into our 3d world (position, target, up vector)
     //bean.transform.translation = (Vector3){ 0.0f, 1.7f, 4.0f };    // Camera position
     //bean.target = (Vector3){ 0.0f, 1.7f, 0.0f };      // Camera looking at point
-    bean.up = (Vector3){ 0.0f, 1.0f, 0.0f };          // Camera up vector (rotation towards target)
+    bean.transform.rotation = QuaternionIdentity();
     
     bean.camera.fovy = 60.0f;                                // Camera field-of-view Y
     bean.camera.projection = CAMERA_PERSPECTIVE;             // Camera projection type
     bean.cameraMode = CAMERA_FIRST_PERSON;
-    UpdateCameraWithBean(&bean);
+    bean.cameraDirty = true;
 
     GameScreen currentScreen = TITLE;
 
@@ -622,13 +959,13 @@ int main(int argc, char *argv[])
 
     //DisableCursor();                    // Limit cursor to relative movement inside the window
 
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "Setting target FPS...");
-    SetTargetFPS(60);                   // Set our game to run at 60 frames-per-second
-    __android_log_print(ANDROID_LOG_INFO, "beangamevr", "Target FPS set");
+    // no SetTargetFPS, xrWaitFrame already paces us to the display and raylib sleeping on top of it only costs frames
 
-    bool connected = false;
     bool client = false;
     bool start = false;
+    // when a connect fails or the connection drops we keep trying, waiting longer after each miss
+    double reconnectTime = 0.0;
+    double reconnectDelay = RECONNECT_MIN_DELAY;
 
     int r;
 
@@ -688,10 +1025,17 @@ int main(int argc, char *argv[])
             continue;
         }
         
+        if ( WaitFrameXR( &TSO ) ) {
+            continue;
+        }
+
         if ( ( r = tsoSyncInput( &TSO ) ) ) {
             return r;
         }
+        SampleXrInput( &TSO, &xrInput, fs.predictedDisplayTime );
 
+        TRACE_BEGIN("frame");
+        TRACE_BEGIN("game update");
         switch(currentScreen) {
             case TITLE:
             {
@@ -736,8 +1080,7 @@ int main(int argc, char *argv[])
                     if(IsGamepadButtonPressed(0, GAMEPAD_AXIS_LEFT_TRIGGER)) {
                         if(bean.cameraMode != CAMERA_FIRST_PERSON) {
                             bean.cameraMode = CAMERA_FIRST_PERSON;
-                            bean.up = (Vector3){ 0.0f, 1.0f, 0.0f }; // Reset roll
-                            UpdateCameraWithBean(&bean);
+                            bean.cameraDirty = true;
                             //updateBeanCollide(&camera, cameraMode);
                         }
                     }
@@ -745,8 +1088,7 @@ int main(int argc, char *argv[])
                     if(IsGamepadButtonPressed(0, GAMEPAD_AXIS_RIGHT_TRIGGER)) {
                         if(bean.cameraMode != CAMERA_THIRD_PERSON) {
                             bean.cameraMode = CAMERA_THIRD_PERSON;
-                            bean.up = (Vector3){ 0.0f, 1.0f, 0.0f }; // Reset roll
-                            UpdateCameraWithBean(&bean);
+                            bean.cameraDirty = true;
                             //updateBeanCollide(&camera, cameraMode);
                         }
                     }
@@ -754,7 +1096,7 @@ int main(int argc, char *argv[])
                     if(IsGamepadButtonPressed(0, GAMEPAD_BUTTON_LEFT_THUMB)) {
                         if(!client) {
                             client = true;
-                            Connect(serverIp);
+                            Connect(serverIp, bean.beanColor, SPAWN_ANY);
                         }
                     }
                     
@@ -766,8 +1108,7 @@ int main(int argc, char *argv[])
                 if ((IsKeyPressed(KEY_ONE))) {
                     if(bean.cameraMode != CAMERA_FIRST_PERSON) {
                         bean.cameraMode = CAMERA_FIRST_PERSON;
-                        bean.up = (Vector3){ 0.0f, 1.0f, 0.0f }; // Reset roll
-                        UpdateCameraWithBean(&bean);
+                        bean.cameraDirty = true;
                         //updateBeanCollide(&camera, cameraMode);
                     }
                 }
@@ -775,8 +1116,7 @@ int main(int argc, char *argv[])
                 if ((IsKeyPressed(KEY_TWO))) {
                     if(bean.cameraMode != CAMERA_THIRD_PERSON) {
                         bean.cameraMode = CAMERA_THIRD_PERSON;
-                        bean.up = (Vector3){ 0.0f, 1.0f, 0.0f }; // Reset roll
-                        UpdateCameraWithBean(&bean);
+                        bean.cameraDirty = true;
                         //updateBeanCollide(&camera, cameraMode);
                     }
                 }
@@ -788,19 +1128,40 @@ int main(int argc, char *argv[])
                     
                 if(!start) {
                     DisableCursor();
-                    Connect(serverIp);
+                    Connect(serverIp, bean.beanColor, SPAWN_ANY);
                     start = true;
                 }
 
                 if (Connected()) {
-                    connected = true;
-                    UpdateLocalBean(&bean);
-                } else if (connected) {
-                    // they hate us sadge
-                    Connect(serverIp);
-                    connected = false;
+                    reconnectDelay = RECONNECT_MIN_DELAY;
+                    GatherBeanLook(&beanIntent);
+                } else if (!Connecting() && GetTime() >= reconnectTime) {
+                    // they hate us sadge. the last try timed out, was turned away or the connection dropped, go again.
+                    // with our token if we still have one, as a new player with the same color if not
+                    Reconnect();
+                    reconnectTime = GetTime() + reconnectDelay;
+                    reconnectDelay = fmin(reconnectDelay * 2.0, RECONNECT_MAX_DELAY);
+                }
+
+                // movement, collision and sends happen in whole ticks, a 120hz frame often runs none and a slow one a few
+                int ticks = AdvanceSimClock(&simClock, GetTime());
+                TRACE_COUNTER("sim ticks", ticks);
+                for (int tick = 0; tick < ticks; tick++) {
+                    if (Connected()) {
+                        GatherBeanIntent(&beanIntent, SIM_TICK);
+                        GatherXrIntent(&xrInput, &beanIntent, SIM_TICK);
+                        UpdateLocalBean(&bean, &beanIntent, &collisionWorld, SIM_TICK);
+
+                        PlayerPose pose;
+                        GetXrPose(&xrInput, &pose);
+                        pose.rotation = bean.transform.rotation;
+                        UpdatePlayerPose(&pose);
+                    }
+                    beanIntent = (BeanIntent){ 0 };
+                    TRACE_BEGIN("network update");
+                    Update(simClock.time, SIM_TICK);
+                    TRACE_END("network update");
                 }
-                Update(GetTime(), GetFrameTime());
                 break;
             }
         }
@@ -815,6 +1176,19 @@ int main(int argc, char *argv[])
             DisableCursor();
         }
 
+        if ((IsKeyPressed(KEY_EIGHT)))
+        {
+            // flip between single pass and two pass stereo to compare them in the trace
+            SetStereoSinglePass(!IsStereoSinglePass());
+        }
+
+        if ((IsKeyPressed(KEY_NINE)))
+        {
+            // dump the last few seconds of frame timings, open it in ui.perfetto.dev
+            TRACE_DUMP(TextFormat("%s/trace.json", gapp->activity->internalDataPath));
+        }
+        TRACE_END("game update");
+
 
         //UpdateLocalBean(&bean);
 
@@ -822,7 +1196,10 @@ int main(int argc, char *argv[])
 
         // Draw
         //----------------------------------------------------------------------------------
+            if (currentScreen == GAMEPLAY) UpdateHudXR(&TSO, IsGamepadAvailable(0));
+
             BeginDrawingXR(&TSO);
+            TRACE_BEGIN("draw");
 
             ClearBackground(BLUE); // for your eyes, DO NOT SET TO RAYWHITE
 
@@ -846,9 +1223,12 @@ int main(int argc, char *argv[])
                 }
                 case GAMEPLAY:
                 {
-                    BeginMode3D(bean.camera);
+                    // drawn a fraction of a tick behind the simulation so motion is smooth at any refresh rate
+                    float simAlpha = GetSimAlpha(&simClock);
+                    BeginMode3D(GetBeanDrawCamera(&bean, simAlpha));
+                    BeginBeans();
                     
-                    DrawPlane((Vector3){ 0.0f, 0.0f, 0.0f }, (Vector2){ 32.0f, 32.0f }, LIGHTGRAY); // Draw ground
+                    DrawWorld();
                     
                     if (!Connected()) {
                         //DrawText("Connecting", 15, 75, 10, BLACK);
@@ -863,17 +1243,10 @@ int main(int argc, char *argv[])
                                 uint8_t g;
                                 uint8_t b;
                                 uint8_t a;
-                                if(GetPlayerPos(i, &pos) && GetPlayerR(i, &r) && GetPlayerG(i, &g) && GetPlayerB(i, &b), GetPlayerA(i, &a)) {
-                                    DrawCapsule(
-                                        (Vector3){pos.x, pos.y + 0.2f, pos.z},
-                                        (Vector3){pos.x, pos.y - 1.0f, pos.z},
-                                        0.7f, 8, 8, (Color){ r, g, b, a }
-                                    );
-                                    DrawCapsuleWires(
-                                        (Vector3){pos.x, pos.y + 0.2f, pos.z},
-                                        (Vector3){pos.x, pos.y - 1.0f, pos.z},
-                                        0.7f, 8, 8, BLACK // an L color tbh
-                                    );
+                                PlayerPose pose;
+                                if(GetPlayerPos(i, &pos) && GetPlayerR(i, &r) && GetPlayerG(i, &g) && GetPlayerB(i, &b) && GetPlayerA(i, &a)) {
+                                    PushBean(i, pos, (Color){ r, g, b, a }); // outline is still black, an L color tbh
+                                    if(GetPlayerPose(i, &pose)) PushPlayerHands(pos, &pose, (Color){ r, g, b, a });
                                 }
                             }
                         }
@@ -881,39 +1254,39 @@ int main(int argc, char *argv[])
                     
                     // Draw bean
                     if (bean.cameraMode == CAMERA_THIRD_PERSON) {
-                        DrawCapsule(bean.topCap, bean.botCap, 0.7f, 8, 8, bean.beanColor);
-                        DrawCapsuleWires(bean.topCap, bean.botCap, 0.7f, 8, 8, BLACK);
+                        PushBean(MAX_PLAYERS, GetBeanDrawPosition(&bean, simAlpha), bean.beanColor);
                         //DrawBoundingBox(beanCollide, VIOLET);
                     }
 
-                    EndMode3D();
+                    // modelview is the camera's view matrix here, so its inverse takes head space to the world
+                    Frustum frustum = TransformFrustum(headFrustum, MatrixInvert(rlGetMatrixModelview()));
+                    CullBeans(&frustum);
+                    DrawBeans();
 
-                    // Draw info boxes
-                    DrawRectangle(5, 5, 330, 85, RED);
-                    DrawRectangleLines(5, 5, 330, 85, BLUE);
-                    DrawText("Player controls:", 15, 15, 10, BLACK);
-                    if(IsGamepadAvailable(0)) {
-                        DrawText("- Move: Left Analog Stick", 15, 30, 10, BLACK);
-                        DrawText("- Look around: Right Analog Stick", 15, 45, 10, BLACK);
-                        DrawText("- Camera mode: Left Trigger, Right Trigger", 15, 60, 10, BLACK);
-                        DrawText("- Generate a new color: Left Thumb", 15, 75, 10, BLACK);
-                    } else {
-                        DrawText("- Move keys: W, A, S, D, Space, Left-Ctrl", 15, 30, 10, BLACK);
-                        DrawText("- Look around: arrow keys or mouse", 15, 45, 10, BLACK);
-                        DrawText("- Camera mode keys: 1, 2", 15, 60, 10, BLACK);
-                        DrawText("- Generate a new color: 3", 15, 75, 10, BLACK);
-                    }
+                    EndMode3D();
+                    // info box is its own quad layer, see UpdateHudXR
                     break;
                 }
             }
+            TRACE_END("draw");
             EndDrawingXR(&TSO);
+            TRACE_END("frame");
         //----------------------------------------------------------------------------------
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    TRACE_DUMP(TextFormat("%s/trace.json", gapp->activity->internalDataPath));
     Disconnect();
-    rlUnloadFramebuffer(fbo);
+    DestroySwapchainFramebuffers();
+    // the color ones go in tsoTeardown, these have to go before the session does
+    depthDestroySwapchains(&TSO);
+    DestroyHudSwapchain();
+    UnloadWorld();
+    UnloadCollisionWorld(&collisionWorld);
+    UnloadLevel(&level);
+    UnloadGovernor();
+    UnloadBeanRenderer();
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
@@ -923,7 +1296,31 @@ int main(int argc, char *argv[])
 
 void UpdateTheBigBean(Vector3 pos, Vector3 tar) {
     bean.transform.translation = pos;
-    bean.target = tar;
+    SetBeanLook(&bean, tar);
+    bean.lastTranslation = pos; // no sliding over from wherever it was before
+    bean.body = (BeanBody){ 0 };
+}
+
+void CorrectTheBigBean(Vector3 pos) {
+    // keeps looking and falling the same way, only where it is changes
+    bean.transform.translation = pos;
+    bean.lastTranslation = pos;
+}
+
+void SpawnTheBigBean(int id, Vector3* pos) {
+    // players get handed out the level's spawn points in turn, no level means the old spot on the field
+    // the server has to know it's a jump, or it sweeps the bean there from wherever it fell to
+    if(level.spawnCount == 0) {
+        *pos = (Vector3){ 0.0f, 1.7f, 4.0f };
+        UpdateTheBigBean(*pos, (Vector3){ 0.0f, 1.7f, 0.0f });
+        TeleportPlayer(*pos);
+        return;
+    }
+
+    LevelSpawn spawn = level.spawns[id % level.spawnCount];
+    *pos = spawn.position;
+    UpdateTheBigBean(*pos, Vector3Add(spawn.position, (Vector3){ -sinf(spawn.yaw), 0.0f, -cosf(spawn.yaw) }));
+    TeleportPlayer(*pos);
 }
 
 bool GetPlayerBoundingBox(int id, BoundingBox* box) {
@@ -931,8 +1328,8 @@ bool GetPlayerBoundingBox(int id, BoundingBox* box) {
         Vector3 pos = { 0 };
         if(GetPlayerPos(id, &pos)) {
             *box = (BoundingBox){
-                (Vector3){pos.x - 0.7f, pos.y - 1.7f, pos.z - 0.7f},
-                (Vector3){pos.x + 0.7f, pos.y + 0.9f, pos.z + 0.7f}
+                (Vector3){pos.x - BEAN_CAPSULE_RADIUS, pos.y + BEAN_CAPSULE_BOTTOM - BEAN_CAPSULE_RADIUS, pos.z - BEAN_CAPSULE_RADIUS},
+                (Vector3){pos.x + BEAN_CAPSULE_RADIUS, pos.y + BEAN_CAPSULE_TOP + BEAN_CAPSULE_RADIUS, pos.z + BEAN_CAPSULE_RADIUS}
             };
             return true;
         }
@@ -948,11 +1345,10 @@ void HandleCollision() {
             if(GetPlayerBoundingBox(i, &box)) {
                 if(CheckCollisionBoxes(bean.beanCollide, box)) {
                     bean.transform.translation = Vector3Subtract(bean.transform.translation, bean.posAdd);
-                    bean.target = Vector3Subtract(bean.target, bean.posAdd);
                     bean.beanCollide = (BoundingBox){
-                        (Vector3){bean.transform.translation.x - 0.7f, bean.transform.translation.y - 1.7f, bean.transform.translation.z - 0.7f},
-                        (Vector3){bean.transform.translation.x + 0.7f, bean.transform.translation.y + 0.9f, bean.transform.translation.z + 0.7f}};
-                    UpdateCameraWithBean(&bean);
+                        (Vector3){bean.transform.translation.x - BEAN_CAPSULE_RADIUS, bean.transform.translation.y + BEAN_CAPSULE_BOTTOM - BEAN_CAPSULE_RADIUS, bean.transform.translation.z - BEAN_CAPSULE_RADIUS},
+                        (Vector3){bean.transform.translation.x + BEAN_CAPSULE_RADIUS, bean.transform.translation.y + BEAN_CAPSULE_TOP + BEAN_CAPSULE_RADIUS, bean.transform.translation.z + BEAN_CAPSULE_RADIUS}};
+                    bean.cameraDirty = true;
                     return;
                 }
             }
@@ -0,0 +1,488 @@
+/**
+	Frame loop check for the mock runtime
+
+	Runs the XR frame loop against libbeangame_mock_runtime.so on the host, with
+	no headset and no OpenXR loader:
+
+		make check
+
+	The runtime is loaded the way the loader does it (dlopen, then
+	xrNegotiateLoaderRuntimeInterface for its xrGetInstanceProcAddr). A headless
+	GLES 3 context comes from EGL. The session is brought up with tsopenxr.h, and
+	frames are submitted the way WaitFrameXR, BeginDrawingXR and EndDrawingXR in
+	main.c do it:
+		* the view and layer structs are built once
+		* there is one framebuffer per color/depth image pair
+		* each projection view has a depth layer chained to it
+		* a double wide color swapchain and a double wide depth swapchain
+	main.c itself needs raylib and the android glue, so it isn't built here.
+
+	Fails (exits 1) if:
+		* any XR call in the loop fails
+		* a frame doesn't end with one layer while the session is visible,
+		  or with none before that
+		* the view configs are enumerated anywhere but at startup, the READY
+		  state change and the reference space change in the script
+
+	Takes the runtime path and the number of frames as optional arguments.
+	The MOCK_XR_ variables still apply, the Makefile runs it free running
+	(MOCK_XR_PACE=0) so it finishes right away.
+
+	Under the MIT/x11 License, like tsopenxr.h.
+*/
+
+#define XR_NO_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dlfcn.h>
+
+#include "openxr/openxr.h"
+
+// Every OpenXR call tsopenxr.h and this file make. Without the loader there are no
+// prototypes to link against, so each one is a pointer filled in from the runtime.
+#define FRAMELOOP_XR_FUNCTIONS(X) \
+	X(xrEnumerateInstanceExtensionProperties) \
+	X(xrCreateInstance) \
+	X(xrDestroyInstance) \
+	X(xrGetInstanceProperties) \
+	X(xrResultToString) \
+	X(xrPollEvent) \
+	X(xrStringToPath) \
+	X(xrGetSystem) \
+	X(xrGetSystemProperties) \
+	X(xrEnumerateViewConfigurationViews) \
+	X(xrCreateSession) \
+	X(xrDestroySession) \
+	X(xrBeginSession) \
+	X(xrEndSession) \
+	X(xrWaitFrame) \
+	X(xrBeginFrame) \
+	X(xrEndFrame) \
+	X(xrEnumerateReferenceSpaces) \
+	X(xrCreateReferenceSpace) \
+	X(xrCreateActionSpace) \
+	X(xrDestroySpace) \
+	X(xrLocateSpace) \
+	X(xrLocateViews) \
+	X(xrEnumerateSwapchainFormats) \
+	X(xrCreateSwapchain) \
+	X(xrDestroySwapchain) \
+	X(xrEnumerateSwapchainImages) \
+	X(xrAcquireSwapchainImage) \
+	X(xrWaitSwapchainImage) \
+	X(xrReleaseSwapchainImage) \
+	X(xrCreateActionSet) \
+	X(xrCreateAction) \
+	X(xrSuggestInteractionProfileBindings) \
+	X(xrAttachSessionActionSets) \
+	X(xrSyncActions)
+
+#define FRAMELOOP_DECLARE(name) static PFN_##name name;
+FRAMELOOP_XR_FUNCTIONS(FRAMELOOP_DECLARE)
+static PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr;
+static PFN_xrEnumerateApiLayerProperties xrEnumerateApiLayerProperties;
+
+// tsopenxr.h binds the session to these on linux, the mock never looks at the binding
+static Display * CNFGDisplay = NULL;
+static uint32_t CNFGVisualID = 0;
+static GLXFBConfig CNFGGLXFBConfig = NULL;
+static GLXDrawable CNFGWindow = 0;
+static GLXContext CNFGCtx = NULL;
+
+#define TSOPENXR_IMPLEMENTATION
+#include "tsopenxr.h"
+
+#define FRAMELOOP_DEFAULT_RUNTIME "./libbeangame_mock_runtime.so"
+#define FRAMELOOP_DEFAULT_FRAMES 300
+// the same script for every run, so the checks below know what to expect
+#define FRAMELOOP_SCRIPT "synchronized@0,visible@1,focused@2,spacechange@100"
+#define FRAMELOOP_SPACE_CHANGES 1
+#define FRAMELOOP_FIRST_VISIBLE 1
+
+//------------------------------------------------------------------------------------
+// Loading the runtime
+//------------------------------------------------------------------------------------
+
+// the loader's side of the negotiation, see mock_runtime.c for the runtime's
+typedef enum
+{
+	FRAMELOOP_STRUCT_LOADER_INFO = 1,
+	FRAMELOOP_STRUCT_RUNTIME_REQUEST = 3,
+} frameloopLoaderStructs;
+
+typedef struct
+{
+	int structType;
+	uint32_t structVersion;
+	size_t structSize;
+	uint32_t minInterfaceVersion;
+	uint32_t maxInterfaceVersion;
+	XrVersion minApiVersion;
+	XrVersion maxApiVersion;
+} frameloopLoaderInfo;
+
+typedef struct
+{
+	int structType;
+	uint32_t structVersion;
+	size_t structSize;
+	uint32_t runtimeInterfaceVersion;
+	XrVersion runtimeApiVersion;
+	PFN_xrGetInstanceProcAddr getInstanceProcAddr;
+} frameloopRuntimeRequest;
+
+typedef XrResult (XRAPI_PTR *PFN_frameloopNegotiate)(const frameloopLoaderInfo * loaderInfo, frameloopRuntimeRequest * runtimeRequest);
+
+// what the runtime got asked for, the checks run on these
+static int viewConfigEnumerations;
+static uint64_t framesEnded;
+static uint64_t framesWithLayers;
+static int badLayerCounts;
+static int expectLayer;
+
+static PFN_xrEnumerateViewConfigurationViews runtimeEnumerateViewConfigurationViews;
+static PFN_xrEndFrame runtimeEndFrame;
+
+// API layers are the loader's business, there are none without it
+static XrResult XRAPI_CALL FrameloopEnumerateApiLayerProperties(uint32_t capacity, uint32_t * count, XrApiLayerProperties * props)
+{
+	*count = 0;
+	return XR_SUCCESS;
+}
+
+// tsoEnumeratetsoViewConfigs asks again right away when the count changed, that second call is the same enumeration
+static XrResult XRAPI_CALL FrameloopEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType type,
+	uint32_t capacity, uint32_t * count, XrViewConfigurationView * views)
+{
+	static int resizing;
+	if (!resizing) viewConfigEnumerations++;
+	XrResult result = runtimeEnumerateViewConfigurationViews(instance, systemId, type, capacity, count, views);
+	resizing = !resizing && XR_SUCCEEDED(result) && *count != capacity;
+	return result;
+}
+
+static XrResult XRAPI_CALL FrameloopEndFrame(XrSession session, const XrFrameEndInfo * info)
+{
+	XrResult result = runtimeEndFrame(session, info);
+	if (XR_SUCCEEDED(result))
+	{
+		framesEnded++;
+		if (info->layerCount) framesWithLayers++;
+		if (info->layerCount != (expectLayer ? 1u : 0u)) badLayerCounts++;
+	}
+	return result;
+}
+
+static int LoadRuntime(const char * path)
+{
+	void * library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!library)
+	{
+		fprintf(stderr, "Couldn't load %s: %s\n", path, dlerror());
+		return 1;
+	}
+
+	PFN_frameloopNegotiate negotiate = (PFN_frameloopNegotiate)dlsym(library, "xrNegotiateLoaderRuntimeInterface");
+	if (!negotiate)
+	{
+		fprintf(stderr, "%s doesn't export xrNegotiateLoaderRuntimeInterface\n", path);
+		return 1;
+	}
+
+	frameloopLoaderInfo loaderInfo = { FRAMELOOP_STRUCT_LOADER_INFO, 1, sizeof(loaderInfo), 1, 1, XR_MAKE_VERSION(1, 0, 0), XR_CURRENT_API_VERSION };
+	frameloopRuntimeRequest request = { FRAMELOOP_STRUCT_RUNTIME_REQUEST, 1, sizeof(request) };
+	if (XR_FAILED(negotiate(&loaderInfo, &request)))
+	{
+		fprintf(stderr, "Negotiating with %s failed\n", path);
+		return 1;
+	}
+	xrGetInstanceProcAddr = request.getInstanceProcAddr;
+	xrEnumerateApiLayerProperties = FrameloopEnumerateApiLayerProperties;
+
+#define FRAMELOOP_RESOLVE(name) \
+	if (XR_FAILED(xrGetInstanceProcAddr(XR_NULL_HANDLE, #name, (PFN_xrVoidFunction *)&name))) \
+	{ \
+		fprintf(stderr, "%s doesn't have " #name "\n", path); \
+		return 1; \
+	}
+	FRAMELOOP_XR_FUNCTIONS(FRAMELOOP_RESOLVE)
+#undef FRAMELOOP_RESOLVE
+
+	runtimeEnumerateViewConfigurationViews = xrEnumerateViewConfigurationViews;
+	xrEnumerateViewConfigurationViews = FrameloopEnumerateViewConfigurationViews;
+	runtimeEndFrame = xrEndFrame;
+	xrEndFrame = FrameloopEndFrame;
+	return 0;
+}
+
+// a GLES 3 context with nothing to draw on, the swapchain images are all the frame loop renders into
+static int CreateContext(void)
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (!eglInitialize(display, NULL, NULL))
+		{
+			fprintf(stderr, "No EGL display\n");
+			return 1;
+		}
+	}
+
+	eglBindAPI(EGL_OPENGL_ES_API);
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_DONT_CARE, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		fprintf(stderr, "No GLES 3 EGL config\n");
+		return 1;
+	}
+
+	const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_NONE };
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		fprintf(stderr, "Couldn't make a GLES 3 context current\n");
+		return 1;
+	}
+
+	printf("GL: %s\n", glGetString(GL_RENDERER));
+	return 0;
+}
+
+//------------------------------------------------------------------------------------
+// The frame loop, submitted like main.c does
+//------------------------------------------------------------------------------------
+
+static XrSwapchain depthSwapchain;
+static XrSwapchainImageOpenGLKHR * depthImages;
+static uint32_t depthImageCount;
+static GLuint * framebuffers;
+static XrView * views;
+static XrCompositionLayerProjectionView * projectionViews;
+static XrCompositionLayerDepthInfoKHR * depthInfos;
+static int framesBuilt;
+
+static int CreateDepthSwapchain(tsoContext * ctx)
+{
+	XrSwapchainCreateInfo sci = { XR_TYPE_SWAPCHAIN_CREATE_INFO };
+	sci.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	sci.format = GL_DEPTH_COMPONENT16;
+	sci.sampleCount = 1;
+	sci.width = ctx->tsoSwapchains[0].width;
+	sci.height = ctx->tsoSwapchains[0].height;
+	sci.faceCount = 1;
+	sci.arraySize = 1;
+	sci.mipCount = 1;
+	XrResult result = xrCreateSwapchain(ctx->tsoSession, &sci, &depthSwapchain);
+	if (tsoCheck(ctx, result, "xrCreateSwapchain [depth]")) return result;
+
+	result = xrEnumerateSwapchainImages(depthSwapchain, 0, &depthImageCount, NULL);
+	if (tsoCheck(ctx, result, "xrEnumerateSwapchainImages [depth]")) return result;
+	depthImages = calloc(depthImageCount, sizeof(XrSwapchainImageOpenGLKHR));
+	for (uint32_t i = 0; i < depthImageCount; i++) depthImages[i].type = XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR;
+	result = xrEnumerateSwapchainImages(depthSwapchain, depthImageCount, &depthImageCount, (XrSwapchainImageBaseHeader *)depthImages);
+	return tsoCheck(ctx, result, "xrEnumerateSwapchainImages [depth]");
+}
+
+// one framebuffer per color/depth pair and the layer structs, once, like CreateSwapchainFramebuffers and CreateFrameLayers
+static int BuildFrame(tsoContext * ctx)
+{
+	uint32_t colorCount = ctx->tsoSwapchainLengths[0];
+	framebuffers = calloc(colorCount * depthImageCount, sizeof(GLuint));
+	glGenFramebuffers(colorCount * depthImageCount, framebuffers);
+	for (uint32_t c = 0; c < colorCount; c++)
+	{
+		for (uint32_t d = 0; d < depthImageCount; d++)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[c * depthImageCount + d]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ctx->tsoSwapchainImages[0][c].image, 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthImages[d].image, 0);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			{
+				fprintf(stderr, "Framebuffer %u/%u is incomplete\n", c, d);
+				return 1;
+			}
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	uint32_t viewCount = ctx->tsoNumViewConfigs;
+	views = calloc(viewCount, sizeof(XrView));
+	projectionViews = calloc(viewCount, sizeof(XrCompositionLayerProjectionView));
+	depthInfos = calloc(viewCount, sizeof(XrCompositionLayerDepthInfoKHR));
+	for (uint32_t i = 0; i < viewCount; i++)
+	{
+		views[i].type = XR_TYPE_VIEW;
+
+		XrCompositionLayerProjectionView * view = &projectionViews[i];
+		view->type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+		view->next = &depthInfos[i];
+		view->subImage.swapchain = ctx->tsoSwapchains[0].handle;
+		view->subImage.imageRect.offset.x = i * ctx->tsoViewConfigs[i].recommendedImageRectWidth;
+		view->subImage.imageRect.extent.width = ctx->tsoViewConfigs[i].recommendedImageRectWidth;
+		view->subImage.imageRect.extent.height = ctx->tsoViewConfigs[i].recommendedImageRectHeight;
+
+		depthInfos[i].type = XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR;
+		depthInfos[i].maxDepth = 1.0f;
+		depthInfos[i].nearZ = 0.01f;
+		depthInfos[i].farZ = 1000.0f;
+		depthInfos[i].subImage = view->subImage;
+		depthInfos[i].subImage.swapchain = depthSwapchain;
+	}
+	framesBuilt = 1;
+	return 0;
+}
+
+static int RunFrame(tsoContext * ctx)
+{
+	XrFrameState fs = { XR_TYPE_FRAME_STATE };
+	XrFrameWaitInfo fwi = { XR_TYPE_FRAME_WAIT_INFO };
+	XrResult result = xrWaitFrame(ctx->tsoSession, &fwi, &fs);
+	if (tsoCheck(ctx, result, "xrWaitFrame")) return result;
+	if (tsoSyncInput(ctx)) return 1;
+
+	XrFrameBeginInfo fbi = { XR_TYPE_FRAME_BEGIN_INFO };
+	result = xrBeginFrame(ctx->tsoSession, &fbi);
+	if (tsoCheck(ctx, result, "xrBeginFrame")) return result;
+
+	if (ctx->tsoViewConfigsDirty)
+	{
+		tsoEnumeratetsoViewConfigs(ctx);
+		ctx->tsoViewConfigsDirty = 0;
+	}
+	if (!ctx->tsoSwapchains)
+	{
+		if ((result = tsoCreateSwapchains(ctx))) return result;
+		if ((result = CreateDepthSwapchain(ctx))) return result;
+	}
+	if (!framesBuilt && BuildFrame(ctx)) return 1;
+
+	XrViewState viewState = { XR_TYPE_VIEW_STATE };
+	XrViewLocateInfo vli = { XR_TYPE_VIEW_LOCATE_INFO };
+	vli.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	vli.displayTime = fs.predictedDisplayTime;
+	vli.space = ctx->tsoStageSpace;
+	uint32_t viewCount = 0;
+	result = xrLocateViews(ctx->tsoSession, &vli, &viewState, ctx->tsoNumViewConfigs, &viewCount, views);
+	if (tsoCheck(ctx, result, "xrLocateViews")) return result;
+	for (uint32_t i = 0; i < viewCount; i++)
+	{
+		projectionViews[i].pose = views[i].pose;
+		projectionViews[i].fov = views[i].fov;
+	}
+
+	XrCompositionLayerProjection layer = { XR_TYPE_COMPOSITION_LAYER_PROJECTION };
+	layer.space = ctx->tsoStageSpace;
+	layer.viewCount = viewCount;
+	layer.views = projectionViews;
+	const XrCompositionLayerBaseHeader * layers[1] = { (XrCompositionLayerBaseHeader *)&layer };
+	uint32_t layerCount = 0;
+
+	expectLayer = fs.shouldRender == XR_TRUE;
+	if (fs.shouldRender == XR_TRUE)
+	{
+		uint32_t colorIndex;
+		uint32_t depthIndex;
+		if (tsoAcquireSwapchain(ctx, 0, &colorIndex)) return 1;
+		XrSwapchainImageAcquireInfo ai = { XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+		result = xrAcquireSwapchainImage(depthSwapchain, &ai, &depthIndex);
+		if (tsoCheck(ctx, result, "xrAcquireSwapchainImage [depth]")) return result;
+		XrSwapchainImageWaitInfo wi = { XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+		wi.timeout = XR_INFINITE_DURATION;
+		result = xrWaitSwapchainImage(depthSwapchain, &wi);
+		if (tsoCheck(ctx, result, "xrWaitSwapchainImage [depth]")) return result;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[colorIndex * depthImageCount + depthIndex]);
+		glViewport(0, 0, ctx->tsoSwapchains[0].width, ctx->tsoSwapchains[0].height);
+		glClearColor(0.4f, 0.6f, 0.9f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (tsoReleaseSwapchain(ctx, 0)) return 1;
+		XrSwapchainImageReleaseInfo ri = { XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+		result = xrReleaseSwapchainImage(depthSwapchain, &ri);
+		if (tsoCheck(ctx, result, "xrReleaseSwapchainImage [depth]")) return result;
+		layerCount = 1;
+	}
+
+	XrFrameEndInfo fei = { XR_TYPE_FRAME_END_INFO };
+	fei.displayTime = fs.predictedDisplayTime;
+	fei.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+	fei.layerCount = layerCount;
+	fei.layers = layers;
+	result = xrEndFrame(ctx->tsoSession, &fei);
+	return tsoCheck(ctx, result, "xrEndFrame");
+}
+
+int main(int argc, char * argv[])
+{
+	const char * runtimePath = argc > 1 ? argv[1] : FRAMELOOP_DEFAULT_RUNTIME;
+	int frames = argc > 2 ? atoi(argv[2]) : FRAMELOOP_DEFAULT_FRAMES;
+	setenv("MOCK_XR_SCRIPT", FRAMELOOP_SCRIPT, 1);
+
+	if (LoadRuntime(runtimePath) || CreateContext()) return 1;
+
+	tsoContext ctx;
+	int r;
+	if ((r = tsoInitialize(&ctx, 3, 2, TSO_DOUBLEWIDE, "Bean Game VR frame loop check", 0))) return 1;
+	if ((r = tsoDefaultCreateActions(&ctx))) return 1;
+
+	// the session comes up on READY, like the game waiting in its main loop
+	for (int i = 0; i < 10 && !ctx.tsoSessionReady; i++) tsoHandleLoop(&ctx);
+	if (!ctx.tsoSessionReady)
+	{
+		fprintf(stderr, "The session never got ready\n");
+		return 1;
+	}
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		tsoHandleLoop(&ctx);
+		if (RunFrame(&ctx))
+		{
+			fprintf(stderr, "Frame %d failed\n", frame);
+			return 1;
+		}
+	}
+
+	glDeleteFramebuffers(ctx.tsoSwapchainLengths[0] * depthImageCount, framebuffers);
+	xrDestroySwapchain(depthSwapchain);
+	tsoTeardown(&ctx);
+
+	// startup, READY and every reference space change, nothing per frame
+	int expectedEnumerations = 2 + FRAMELOOP_SPACE_CHANGES;
+	uint64_t expectedWithLayers = (uint64_t)frames - FRAMELOOP_FIRST_VISIBLE;
+	printf("%llu frames ended, %llu with a layer, %d with the wrong layer count, view configs enumerated %d times\n",
+		(unsigned long long)framesEnded, (unsigned long long)framesWithLayers, badLayerCounts, viewConfigEnumerations);
+
+	int failed = 0;
+	if (framesEnded != (uint64_t)frames)
+	{
+		fprintf(stderr, "FAIL: %d frames run but %llu ended\n", frames, (unsigned long long)framesEnded);
+		failed = 1;
+	}
+	if (badLayerCounts || framesWithLayers != expectedWithLayers)
+	{
+		fprintf(stderr, "FAIL: expected %llu frames with the projection layer\n", (unsigned long long)expectedWithLayers);
+		failed = 1;
+	}
+	if (viewConfigEnumerations != expectedEnumerations)
+	{
+		fprintf(stderr, "FAIL: expected the view configs enumerated %d times\n", expectedEnumerations);
+		failed = 1;
+	}
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed;
+}
@@ -0,0 +1,1083 @@
+/**
+	Bean Game VR mock OpenXR runtime
+
+	A tiny OpenXR runtime that is loaded through the loader's runtime JSON
+	(see mock_runtime.json) so the tsopenxr.h session code and the XR frame
+	loop in main.c can run without a headset.
+
+	It provides:
+		* scripted session state transitions
+		* swapchains backed by plain GL textures created in the app's context
+		* a configurable predictedDisplayPeriod, with optional pacing
+		* synthetic head, eye and controller poses plus controller input
+
+	Everything is configured through environment variables:
+
+		MOCK_XR_DISPLAY_HZ      display rate used for predictedDisplayPeriod (default 72)
+		MOCK_XR_PACE            1 = xrWaitFrame blocks until the next vsync, 0 = free-run (default 1)
+		MOCK_XR_EYE_WIDTH       recommendedImageRectWidth per eye (default 1440)
+		MOCK_XR_EYE_HEIGHT      recommendedImageRectHeight per eye (default 1584)
+		MOCK_XR_SCRIPT          session state script, see below
+		MOCK_XR_STATIC_POSE     1 = head and hands never move (default 0)
+
+	MOCK_XR_SCRIPT is a comma separated list of state@frame entries, where
+	frame counts xrWaitFrame calls since xrBeginSession, for example:
+
+		MOCK_XR_SCRIPT=synchronized@0,visible@1,focused@2,visible@600,focused@700,stopping@1000
+
+	IDLE and READY are always queued when the session is created.
+	"spacechange@N" queues an XrEventDataReferenceSpaceChangePending for the stage space.
+
+	On xrDestroySession a short summary of the frame loop is printed, which is
+	the number to watch when benchmarking the per-frame XR overhead.
+
+	Under the MIT/x11 License, like tsopenxr.h.
+*/
+
+#define XR_NO_PROTOTYPES
+#define XR_USE_GRAPHICS_API_OPENGL
+#define XR_USE_GRAPHICS_API_OPENGL_ES
+#include <EGL/egl.h>
+#include "openxr/openxr.h"
+#include "openxr/openxr_platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#define MOCK_EXPORT __attribute__((visibility("default")))
+
+#define MOCK_INFO(...) fprintf(stderr, "[mock_xr] " __VA_ARGS__)
+
+// Loader <-> runtime negotiation structures. These normally come from the loader's
+// openxr_loader_negotiation.h, which is newer than the headers vendored in include/openxr.
+typedef enum XrLoaderInterfaceStructs
+{
+	XR_LOADER_INTERFACE_STRUCT_UNINTIALIZED = 0,
+	XR_LOADER_INTERFACE_STRUCT_LOADER_INFO,
+	XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST,
+	XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST,
+	XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO,
+	XR_LOADER_INTERFACE_STRUCT_API_LAYER_NEXT_INFO,
+} XrLoaderInterfaceStructs;
+
+#define XR_LOADER_INFO_STRUCT_VERSION 1
+typedef struct XrNegotiateLoaderInfo
+{
+	XrLoaderInterfaceStructs structType;
+	uint32_t structVersion;
+	size_t structSize;
+	uint32_t minInterfaceVersion;
+	uint32_t maxInterfaceVersion;
+	XrVersion minApiVersion;
+	XrVersion maxApiVersion;
+} XrNegotiateLoaderInfo;
+
+#define XR_RUNTIME_INFO_STRUCT_VERSION 1
+typedef struct XrNegotiateRuntimeRequest
+{
+	XrLoaderInterfaceStructs structType;
+	uint32_t structVersion;
+	size_t structSize;
+	uint32_t runtimeInterfaceVersion;
+	XrVersion runtimeApiVersion;
+	PFN_xrGetInstanceProcAddr getInstanceProcAddr;
+} XrNegotiateRuntimeRequest;
+
+#define XR_CURRENT_LOADER_RUNTIME_VERSION 1
+
+// GL entry points, resolved from whatever GL library the application already loaded.
+#define MOCK_GL_TEXTURE_2D 0x0DE1
+typedef void (*PFN_mockGenTextures)(int n, unsigned int * textures);
+typedef void (*PFN_mockDeleteTextures)(int n, const unsigned int * textures);
+typedef void (*PFN_mockBindTexture)(unsigned int target, unsigned int texture);
+typedef void (*PFN_mockTexStorage2D)(unsigned int target, int levels, unsigned int internalformat, int width, int height);
+
+static struct
+{
+	PFN_mockGenTextures GenTextures;
+	PFN_mockDeleteTextures DeleteTextures;
+	PFN_mockBindTexture BindTexture;
+	PFN_mockTexStorage2D TexStorage2D;
+} gl;
+
+// Formats offered by xrEnumerateSwapchainFormats, in order of runtime preference.
+static const int64_t mockSwapchainFormats[] = {
+	0x8C43, // GL_SRGB8_ALPHA8
+	0x8058, // GL_RGBA8
+	0x81A5, // GL_DEPTH_COMPONENT16
+	0x81A6, // GL_DEPTH_COMPONENT24
+};
+
+#define MOCK_SWAPCHAIN_LENGTH 3
+#define MOCK_MAX_PATHS 256
+#define MOCK_MAX_EVENTS 32
+#define MOCK_MAX_SCRIPT 64
+#define MOCK_MAX_LAYERS 16
+
+typedef enum { MOCK_SPACE_REFERENCE, MOCK_SPACE_ACTION } mockSpaceKind;
+
+typedef struct
+{
+	mockSpaceKind kind;
+	XrReferenceSpaceType referenceType;
+	XrPath subactionPath;
+	XrPosef offset;
+} mockSpace;
+
+typedef struct
+{
+	XrActionType type;
+	char name[XR_MAX_ACTION_NAME_SIZE];
+} mockAction;
+
+typedef struct
+{
+	uint32_t images[MOCK_SWAPCHAIN_LENGTH];
+	uint32_t nextImage;
+	int acquired;
+	int64_t format;
+	uint32_t width;
+	uint32_t height;
+} mockSwapchain;
+
+typedef struct
+{
+	XrSessionState state;
+	uint64_t frame;
+	int isSpaceChange;
+} mockScriptEntry;
+
+// The whole runtime is a single instance with at most one session, which is all the game needs.
+static struct
+{
+	int instanceAlive;
+	int sessionAlive;
+	int sessionRunning;
+	XrSessionState state;
+
+	char paths[MOCK_MAX_PATHS][XR_MAX_PATH_LENGTH];
+	int numPaths;
+
+	XrEventDataBuffer events[MOCK_MAX_EVENTS];
+	int eventHead;
+	int eventCount;
+
+	mockScriptEntry script[MOCK_MAX_SCRIPT];
+	int scriptCount;
+	int scriptNext;
+
+	XrDuration displayPeriod;
+	int pace;
+	int staticPose;
+	uint32_t eyeWidth;
+	uint32_t eyeHeight;
+
+	XrTime epoch;
+	XrTime nextDisplayTime;
+	uint64_t framesWaited;
+	uint64_t framesBegun;
+	uint64_t framesEnded;
+	uint64_t layersSubmitted;
+	uint64_t framesMissed;
+	XrTime beginTime;
+	XrTime appTimeTotal;
+	XrTime appTimeMax;
+} mock;
+
+static XrTime MockNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (XrTime)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int MockEnvInt(const char * name, int fallback)
+{
+	const char * v = getenv(name);
+	return (v && *v) ? atoi(v) : fallback;
+}
+
+static void MockResolveGL(void)
+{
+	if (gl.GenTextures) return;
+	gl.GenTextures = (PFN_mockGenTextures)dlsym(RTLD_DEFAULT, "glGenTextures");
+	gl.DeleteTextures = (PFN_mockDeleteTextures)dlsym(RTLD_DEFAULT, "glDeleteTextures");
+	gl.BindTexture = (PFN_mockBindTexture)dlsym(RTLD_DEFAULT, "glBindTexture");
+	gl.TexStorage2D = (PFN_mockTexStorage2D)dlsym(RTLD_DEFAULT, "glTexStorage2D");
+	if (!gl.GenTextures || !gl.BindTexture || !gl.TexStorage2D)
+	{
+		MOCK_INFO("GL entry points not found, swapchain images will be fake names\n");
+	}
+}
+
+//------------------------------------------------------------------------------------
+// Math for synthetic poses
+//------------------------------------------------------------------------------------
+
+static XrQuaternionf MockQuatMul(XrQuaternionf a, XrQuaternionf b)
+{
+	XrQuaternionf r;
+	r.x = a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y;
+	r.y = a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x;
+	r.z = a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w;
+	r.w = a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z;
+	return r;
+}
+
+static XrQuaternionf MockQuatConj(XrQuaternionf q)
+{
+	return (XrQuaternionf){ -q.x, -q.y, -q.z, q.w };
+}
+
+static XrVector3f MockQuatRotate(XrQuaternionf q, XrVector3f v)
+{
+	XrQuaternionf p = { v.x, v.y, v.z, 0.0f };
+	XrQuaternionf r = MockQuatMul(MockQuatMul(q, p), MockQuatConj(q));
+	return (XrVector3f){ r.x, r.y, r.z };
+}
+
+static XrQuaternionf MockQuatAxisAngle(float x, float y, float z, float angle)
+{
+	float s = sinf(angle*0.5f);
+	return (XrQuaternionf){ x*s, y*s, z*s, cosf(angle*0.5f) };
+}
+
+// a * b, where b is expressed in a's frame
+static XrPosef MockPoseMul(XrPosef a, XrPosef b)
+{
+	XrPosef r;
+	r.orientation = MockQuatMul(a.orientation, b.orientation);
+	XrVector3f p = MockQuatRotate(a.orientation, b.position);
+	r.position = (XrVector3f){ a.position.x + p.x, a.position.y + p.y, a.position.z + p.z };
+	return r;
+}
+
+static XrPosef MockPoseInvert(XrPosef a)
+{
+	XrPosef r;
+	r.orientation = MockQuatConj(a.orientation);
+	XrVector3f p = MockQuatRotate(r.orientation, a.position);
+	r.position = (XrVector3f){ -p.x, -p.y, -p.z };
+	return r;
+}
+
+static const XrPosef mockIdentity = { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } };
+
+static float MockSeconds(XrTime time)
+{
+	return mock.staticPose ? 0.0f : (float)((double)(time - mock.epoch) * 1e-9);
+}
+
+// Head in stage space: standing at 1.7m, slowly looking around and swaying.
+static XrPosef MockHeadPose(XrTime time)
+{
+	float t = MockSeconds(time);
+	XrPosef pose;
+	pose.orientation = MockQuatMul(MockQuatAxisAngle(0.0f, 1.0f, 0.0f, 0.6f*sinf(t*0.5f)),
+								   MockQuatAxisAngle(1.0f, 0.0f, 0.0f, 0.15f*sinf(t*0.7f)));
+	pose.position = (XrVector3f){ 0.05f*sinf(t*1.3f), 1.7f + 0.02f*sinf(t*2.1f), 0.05f*cosf(t*0.9f) };
+	return pose;
+}
+
+// Hand grip poses relative to the head, tracing small circles in front of the user.
+static XrPosef MockHandPose(XrTime time, int hand)
+{
+	float t = MockSeconds(time);
+	float side = hand ? 1.0f : -1.0f;
+	XrPosef local;
+	local.orientation = MockQuatAxisAngle(1.0f, 0.0f, 0.0f, -0.5f + 0.2f*sinf(t + hand));
+	local.position = (XrVector3f){ side*0.2f + 0.05f*cosf(t*1.5f), -0.35f + 0.05f*sinf(t*1.5f), -0.35f };
+	return MockPoseMul(MockHeadPose(time), local);
+}
+
+static int MockHandFromPath(XrPath path)
+{
+	if (path == XR_NULL_PATH || path > (XrPath)mock.numPaths) return -1;
+	const char * str = mock.paths[path - 1];
+	if (!strncmp(str, "/user/hand/left", 15)) return 0;
+	if (!strncmp(str, "/user/hand/right", 16)) return 1;
+	return -1;
+}
+
+// Pose of a space in stage space.
+static XrPosef MockSpaceInStage(const mockSpace * space, XrTime time)
+{
+	XrPosef base = mockIdentity;
+	if (space->kind == MOCK_SPACE_ACTION)
+	{
+		int hand = MockHandFromPath(space->subactionPath);
+		base = MockHandPose(time, hand < 0 ? 0 : hand);
+	}
+	else if (space->referenceType == XR_REFERENCE_SPACE_TYPE_VIEW)
+	{
+		base = MockHeadPose(time);
+	}
+	else if (space->referenceType == XR_REFERENCE_SPACE_TYPE_LOCAL)
+	{
+		base.position.y = 1.7f;
+	}
+	return MockPoseMul(base, space->offset);
+}
+
+//------------------------------------------------------------------------------------
+// Events and session state script
+//------------------------------------------------------------------------------------
+
+static void MockPushEvent(const void * event, size_t size)
+{
+	if (mock.eventCount == MOCK_MAX_EVENTS)
+	{
+		MOCK_INFO("event queue overflow, dropping event\n");
+		return;
+	}
+	XrEventDataBuffer * slot = &mock.events[(mock.eventHead + mock.eventCount) % MOCK_MAX_EVENTS];
+	memset(slot, 0, sizeof(*slot));
+	memcpy(slot, event, size);
+	mock.eventCount++;
+}
+
+static void MockSetState(XrSession session, XrSessionState state)
+{
+	XrEventDataSessionStateChanged ev = { XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED };
+	ev.session = session;
+	ev.state = state;
+	ev.time = MockNow();
+	mock.state = state;
+	MockPushEvent(&ev, sizeof(ev));
+}
+
+static int MockParseState(const char * name, XrSessionState * state)
+{
+	static const struct { const char * name; XrSessionState state; } states[] = {
+		{ "idle", XR_SESSION_STATE_IDLE },
+		{ "ready", XR_SESSION_STATE_READY },
+		{ "synchronized", XR_SESSION_STATE_SYNCHRONIZED },
+		{ "visible", XR_SESSION_STATE_VISIBLE },
+		{ "focused", XR_SESSION_STATE_FOCUSED },
+		{ "stopping", XR_SESSION_STATE_STOPPING },
+		{ "loss_pending", XR_SESSION_STATE_LOSS_PENDING },
+		{ "exiting", XR_SESSION_STATE_EXITING },
+	};
+	for (size_t i = 0; i < sizeof(states)/sizeof(states[0]); i++)
+	{
+		if (!strcmp(name, states[i].name))
+		{
+			*state = states[i].state;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void MockLoadScript(void)
+{
+	const char * script = getenv("MOCK_XR_SCRIPT");
+	if (!script || !*script) script = "synchronized@0,visible@1,focused@2";
+
+	char buffer[1024];
+	snprintf(buffer, sizeof(buffer), "%s", script);
+
+	mock.scriptCount = 0;
+	mock.scriptNext = 0;
+	for (char * entry = strtok(buffer, ","); entry && mock.scriptCount < MOCK_MAX_SCRIPT; entry = strtok(NULL, ","))
+	{
+		char * at = strchr(entry, '@');
+		mockScriptEntry * e = &mock.script[mock.scriptCount];
+		e->frame = at ? strtoull(at + 1, NULL, 10) : 0;
+		if (at) *at = '\0';
+		e->isSpaceChange = !strcmp(entry, "spacechange");
+		if (!e->isSpaceChange && !MockParseState(entry, &e->state))
+		{
+			MOCK_INFO("unknown state '%s' in MOCK_XR_SCRIPT\n", entry);
+			continue;
+		}
+		mock.scriptCount++;
+	}
+}
+
+static void MockRunScript(XrSession session)
+{
+	while (mock.scriptNext < mock.scriptCount && mock.script[mock.scriptNext].frame <= mock.framesWaited)
+	{
+		const mockScriptEntry * e = &mock.script[mock.scriptNext++];
+		if (e->isSpaceChange)
+		{
+			XrEventDataReferenceSpaceChangePending ev = { XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING };
+			ev.session = session;
+			ev.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
+			ev.changeTime = mock.nextDisplayTime;
+			ev.poseValid = XR_TRUE;
+			ev.poseInPreviousSpace = mockIdentity;
+			MockPushEvent(&ev, sizeof(ev));
+		}
+		else
+		{
+			MockSetState(session, e->state);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------
+// Instance
+//------------------------------------------------------------------------------------
+
+static const char * mockExtensions[] = {
+	XR_KHR_OPENGL_ENABLE_EXTENSION_NAME,
+	XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME,
+	XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME,
+};
+
+static XrResult XRAPI_CALL MockEnumerateInstanceExtensionProperties(const char * layerName, uint32_t capacity, uint32_t * count, XrExtensionProperties * props)
+{
+	uint32_t n = sizeof(mockExtensions)/sizeof(mockExtensions[0]);
+	*count = n;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < n) return XR_ERROR_SIZE_INSUFFICIENT;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		snprintf(props[i].extensionName, XR_MAX_EXTENSION_NAME_SIZE, "%s", mockExtensions[i]);
+		props[i].extensionVersion = 1;
+	}
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockCreateInstance(const XrInstanceCreateInfo * info, XrInstance * instance)
+{
+	if (mock.instanceAlive) return XR_ERROR_LIMIT_REACHED;
+
+	memset(&mock, 0, sizeof(mock));
+	mock.instanceAlive = 1;
+	mock.displayPeriod = 1000000000 / (XrDuration)MockEnvInt("MOCK_XR_DISPLAY_HZ", 72);
+	mock.pace = MockEnvInt("MOCK_XR_PACE", 1);
+	mock.staticPose = MockEnvInt("MOCK_XR_STATIC_POSE", 0);
+	mock.eyeWidth = (uint32_t)MockEnvInt("MOCK_XR_EYE_WIDTH", 1440);
+	mock.eyeHeight = (uint32_t)MockEnvInt("MOCK_XR_EYE_HEIGHT", 1584);
+	mock.epoch = MockNow();
+	MockLoadScript();
+
+	MOCK_INFO("instance for \"%s\", %.2f Hz, %ux%u per eye, %s\n", info->applicationInfo.applicationName,
+		1e9/(double)mock.displayPeriod, mock.eyeWidth, mock.eyeHeight, mock.pace ? "paced" : "free-running");
+
+	*instance = (XrInstance)(uintptr_t)&mock;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroyInstance(XrInstance instance)
+{
+	mock.instanceAlive = 0;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetInstanceProperties(XrInstance instance, XrInstanceProperties * props)
+{
+	props->runtimeVersion = XR_MAKE_VERSION(0, 1, 0);
+	snprintf(props->runtimeName, XR_MAX_RUNTIME_NAME_SIZE, "Bean Game VR mock runtime");
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE])
+{
+	switch (value)
+	{
+	case XR_SUCCESS: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_SUCCESS"); break;
+	case XR_SESSION_NOT_FOCUSED: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_SESSION_NOT_FOCUSED"); break;
+	case XR_EVENT_UNAVAILABLE: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_EVENT_UNAVAILABLE"); break;
+	case XR_ERROR_CALL_ORDER_INVALID: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_ERROR_CALL_ORDER_INVALID"); break;
+	case XR_ERROR_SESSION_NOT_RUNNING: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_ERROR_SESSION_NOT_RUNNING"); break;
+	case XR_ERROR_SIZE_INSUFFICIENT: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_ERROR_SIZE_INSUFFICIENT"); break;
+	case XR_ERROR_FUNCTION_UNSUPPORTED: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_ERROR_FUNCTION_UNSUPPORTED"); break;
+	default: snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_UNKNOWN_%d", (int)value); break;
+	}
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockPollEvent(XrInstance instance, XrEventDataBuffer * event)
+{
+	if (mock.eventCount == 0) return XR_EVENT_UNAVAILABLE;
+	*event = mock.events[mock.eventHead];
+	mock.eventHead = (mock.eventHead + 1) % MOCK_MAX_EVENTS;
+	mock.eventCount--;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockStringToPath(XrInstance instance, const char * str, XrPath * path)
+{
+	for (int i = 0; i < mock.numPaths; i++)
+	{
+		if (!strcmp(mock.paths[i], str))
+		{
+			*path = (XrPath)(i + 1);
+			return XR_SUCCESS;
+		}
+	}
+	if (mock.numPaths == MOCK_MAX_PATHS) return XR_ERROR_PATH_COUNT_EXCEEDED;
+	snprintf(mock.paths[mock.numPaths], XR_MAX_PATH_LENGTH, "%s", str);
+	*path = (XrPath)(++mock.numPaths);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockPathToString(XrInstance instance, XrPath path, uint32_t capacity, uint32_t * count, char * buffer)
+{
+	if (path == XR_NULL_PATH || path > (XrPath)mock.numPaths) return XR_ERROR_PATH_INVALID;
+	const char * str = mock.paths[path - 1];
+	*count = (uint32_t)strlen(str) + 1;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < *count) return XR_ERROR_SIZE_INSUFFICIENT;
+	memcpy(buffer, str, *count);
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// System
+//------------------------------------------------------------------------------------
+
+#define MOCK_SYSTEM_ID 1
+
+static XrResult XRAPI_CALL MockGetSystem(XrInstance instance, const XrSystemGetInfo * info, XrSystemId * systemId)
+{
+	if (info->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+	*systemId = MOCK_SYSTEM_ID;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties * props)
+{
+	props->systemId = systemId;
+	props->vendorId = 0;
+	snprintf(props->systemName, XR_MAX_SYSTEM_NAME_SIZE, "Mock HMD");
+	props->graphicsProperties.maxLayerCount = MOCK_MAX_LAYERS;
+	props->graphicsProperties.maxSwapchainImageWidth = 8192;
+	props->graphicsProperties.maxSwapchainImageHeight = 8192;
+	props->trackingProperties.orientationTracking = XR_TRUE;
+	props->trackingProperties.positionTracking = XR_TRUE;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType type,
+	uint32_t capacity, uint32_t * count, XrViewConfigurationView * views)
+{
+	if (type != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	*count = 2;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < 2) return XR_ERROR_SIZE_INSUFFICIENT;
+	for (int i = 0; i < 2; i++)
+	{
+		views[i].recommendedImageRectWidth = mock.eyeWidth;
+		views[i].maxImageRectWidth = mock.eyeWidth*2;
+		views[i].recommendedImageRectHeight = mock.eyeHeight;
+		views[i].maxImageRectHeight = mock.eyeHeight*2;
+		views[i].recommendedSwapchainSampleCount = 1;
+		views[i].maxSwapchainSampleCount = 4;
+	}
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetOpenGLGraphicsRequirementsKHR(XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsOpenGLKHR * reqs)
+{
+	reqs->minApiVersionSupported = XR_MAKE_VERSION(3, 0, 0);
+	reqs->maxApiVersionSupported = XR_MAKE_VERSION(4, 6, 0);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetOpenGLESGraphicsRequirementsKHR(XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsOpenGLESKHR * reqs)
+{
+	reqs->minApiVersionSupported = XR_MAKE_VERSION(3, 0, 0);
+	reqs->maxApiVersionSupported = XR_MAKE_VERSION(3, 2, 0);
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Session and frame loop
+//------------------------------------------------------------------------------------
+
+static XrResult XRAPI_CALL MockCreateSession(XrInstance instance, const XrSessionCreateInfo * info, XrSession * session)
+{
+	if (mock.sessionAlive) return XR_ERROR_LIMIT_REACHED;
+	MockResolveGL();
+	mock.sessionAlive = 1;
+	*session = (XrSession)(uintptr_t)&mock.sessionAlive;
+	MockSetState(*session, XR_SESSION_STATE_IDLE);
+	MockSetState(*session, XR_SESSION_STATE_READY);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroySession(XrSession session)
+{
+	if (mock.framesEnded)
+	{
+		MOCK_INFO("%llu frames, %llu layers, %llu missed vsyncs, app frame time avg %.3f ms max %.3f ms\n",
+			(unsigned long long)mock.framesEnded, (unsigned long long)mock.layersSubmitted, (unsigned long long)mock.framesMissed,
+			(double)mock.appTimeTotal / (double)mock.framesEnded * 1e-6, (double)mock.appTimeMax * 1e-6);
+	}
+	mock.sessionAlive = 0;
+	mock.sessionRunning = 0;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockBeginSession(XrSession session, const XrSessionBeginInfo * info)
+{
+	if (mock.sessionRunning) return XR_ERROR_SESSION_RUNNING;
+	mock.sessionRunning = 1;
+	mock.framesWaited = 0;
+	mock.nextDisplayTime = MockNow() + mock.displayPeriod;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockEndSession(XrSession session)
+{
+	if (!mock.sessionRunning) return XR_ERROR_SESSION_NOT_RUNNING;
+	mock.sessionRunning = 0;
+	MockSetState(session, XR_SESSION_STATE_IDLE);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockRequestExitSession(XrSession session)
+{
+	if (!mock.sessionRunning) return XR_ERROR_SESSION_NOT_RUNNING;
+	MockSetState(session, XR_SESSION_STATE_STOPPING);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockWaitFrame(XrSession session, const XrFrameWaitInfo * info, XrFrameState * state)
+{
+	if (!mock.sessionRunning) return XR_ERROR_SESSION_NOT_RUNNING;
+
+	XrTime now = MockNow();
+	if (mock.pace)
+	{
+		// block until one period before the frame is displayed, like a compositor would
+		XrTime wake = mock.nextDisplayTime - mock.displayPeriod;
+		if (wake > now)
+		{
+			struct timespec ts = { (time_t)((wake - now) / 1000000000), (long)((wake - now) % 1000000000) };
+			nanosleep(&ts, NULL);
+			now = MockNow();
+		}
+	}
+
+	// the app fell behind, skip ahead to the next vsync we can still make
+	while (mock.nextDisplayTime < now + mock.displayPeriod/2)
+	{
+		mock.nextDisplayTime += mock.displayPeriod;
+		mock.framesMissed++;
+	}
+
+	state->predictedDisplayTime = mock.nextDisplayTime;
+	state->predictedDisplayPeriod = mock.displayPeriod;
+	state->shouldRender = (mock.state == XR_SESSION_STATE_VISIBLE || mock.state == XR_SESSION_STATE_FOCUSED) ? XR_TRUE : XR_FALSE;
+
+	mock.nextDisplayTime += mock.displayPeriod;
+	mock.framesWaited++;
+	MockRunScript(session);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockBeginFrame(XrSession session, const XrFrameBeginInfo * info)
+{
+	if (!mock.sessionRunning) return XR_ERROR_SESSION_NOT_RUNNING;
+	if (mock.framesBegun >= mock.framesWaited) return XR_ERROR_CALL_ORDER_INVALID;
+	XrResult result = (mock.framesBegun > mock.framesEnded) ? XR_FRAME_DISCARDED : XR_SUCCESS;
+	mock.framesBegun = mock.framesWaited;
+	mock.beginTime = MockNow();
+	return result;
+}
+
+static XrResult XRAPI_CALL MockEndFrame(XrSession session, const XrFrameEndInfo * info)
+{
+	if (!mock.sessionRunning) return XR_ERROR_SESSION_NOT_RUNNING;
+	if (mock.framesEnded >= mock.framesBegun) return XR_ERROR_CALL_ORDER_INVALID;
+	if (info->layerCount > MOCK_MAX_LAYERS) return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+	for (uint32_t i = 0; i < info->layerCount; i++)
+	{
+		if (!info->layers[i]) return XR_ERROR_LAYER_INVALID;
+	}
+
+	XrTime appTime = MockNow() - mock.beginTime;
+	mock.appTimeTotal += appTime;
+	if (appTime > mock.appTimeMax) mock.appTimeMax = appTime;
+	mock.layersSubmitted += info->layerCount;
+	mock.framesEnded = mock.framesBegun;
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Spaces and views
+//------------------------------------------------------------------------------------
+
+static XrResult XRAPI_CALL MockEnumerateReferenceSpaces(XrSession session, uint32_t capacity, uint32_t * count, XrReferenceSpaceType * spaces)
+{
+	static const XrReferenceSpaceType types[] = { XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL, XR_REFERENCE_SPACE_TYPE_STAGE };
+	*count = 3;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < 3) return XR_ERROR_SIZE_INSUFFICIENT;
+	memcpy(spaces, types, sizeof(types));
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo * info, XrSpace * space)
+{
+	mockSpace * s = calloc(1, sizeof(mockSpace));
+	s->kind = MOCK_SPACE_REFERENCE;
+	s->referenceType = info->referenceSpaceType;
+	s->offset = info->poseInReferenceSpace;
+	*space = (XrSpace)(uintptr_t)s;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo * info, XrSpace * space)
+{
+	mockSpace * s = calloc(1, sizeof(mockSpace));
+	s->kind = MOCK_SPACE_ACTION;
+	s->subactionPath = info->subactionPath;
+	s->offset = info->poseInActionSpace;
+	*space = (XrSpace)(uintptr_t)s;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroySpace(XrSpace space)
+{
+	free((void *)(uintptr_t)space);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation * location)
+{
+	const mockSpace * s = (const mockSpace *)(uintptr_t)space;
+	const mockSpace * b = (const mockSpace *)(uintptr_t)baseSpace;
+	location->pose = MockPoseMul(MockPoseInvert(MockSpaceInStage(b, time)), MockSpaceInStage(s, time));
+	location->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+		XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockLocateViews(XrSession session, const XrViewLocateInfo * info, XrViewState * viewState,
+	uint32_t capacity, uint32_t * count, XrView * views)
+{
+	*count = 2;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < 2) return XR_ERROR_SIZE_INSUFFICIENT;
+
+	const mockSpace * b = (const mockSpace *)(uintptr_t)info->space;
+	XrPosef head = MockPoseMul(MockPoseInvert(MockSpaceInStage(b, info->displayTime)), MockHeadPose(info->displayTime));
+
+	for (int i = 0; i < 2; i++)
+	{
+		XrPosef eye = mockIdentity;
+		eye.position.x = (i ? 0.5f : -0.5f) * 0.063f;
+		views[i].pose = MockPoseMul(head, eye);
+		// roughly Quest 2 shaped, slightly wider towards the outside of each eye
+		views[i].fov.angleLeft = i ? -0.79f : -0.94f;
+		views[i].fov.angleRight = i ? 0.94f : 0.79f;
+		views[i].fov.angleUp = 0.84f;
+		views[i].fov.angleDown = -0.91f;
+	}
+	viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+		XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Swapchains
+//------------------------------------------------------------------------------------
+
+static XrResult XRAPI_CALL MockEnumerateSwapchainFormats(XrSession session, uint32_t capacity, uint32_t * count, int64_t * formats)
+{
+	uint32_t n = sizeof(mockSwapchainFormats)/sizeof(mockSwapchainFormats[0]);
+	*count = n;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < n) return XR_ERROR_SIZE_INSUFFICIENT;
+	memcpy(formats, mockSwapchainFormats, sizeof(mockSwapchainFormats));
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockCreateSwapchain(XrSession session, const XrSwapchainCreateInfo * info, XrSwapchain * swapchain)
+{
+	mockSwapchain * sc = calloc(1, sizeof(mockSwapchain));
+	sc->format = info->format;
+	sc->width = info->width;
+	sc->height = info->height;
+
+	if (gl.GenTextures && gl.TexStorage2D)
+	{
+		gl.GenTextures(MOCK_SWAPCHAIN_LENGTH, sc->images);
+		for (int i = 0; i < MOCK_SWAPCHAIN_LENGTH; i++)
+		{
+			gl.BindTexture(MOCK_GL_TEXTURE_2D, sc->images[i]);
+			gl.TexStorage2D(MOCK_GL_TEXTURE_2D, 1, (unsigned int)info->format, (int)info->width, (int)info->height);
+		}
+		gl.BindTexture(MOCK_GL_TEXTURE_2D, 0);
+	}
+	else
+	{
+		static uint32_t fakeName = 0x1000;
+		for (int i = 0; i < MOCK_SWAPCHAIN_LENGTH; i++) sc->images[i] = fakeName++;
+	}
+
+	*swapchain = (XrSwapchain)(uintptr_t)sc;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroySwapchain(XrSwapchain swapchain)
+{
+	mockSwapchain * sc = (mockSwapchain *)(uintptr_t)swapchain;
+	if (gl.DeleteTextures && gl.GenTextures) gl.DeleteTextures(MOCK_SWAPCHAIN_LENGTH, sc->images);
+	free(sc);
+	return XR_SUCCESS;
+}
+
+// XrSwapchainImageOpenGLKHR and XrSwapchainImageOpenGLESKHR share this layout
+typedef struct
+{
+	XrStructureType type;
+	void * next;
+	uint32_t image;
+} mockSwapchainImageGL;
+
+static XrResult XRAPI_CALL MockEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t capacity, uint32_t * count, XrSwapchainImageBaseHeader * images)
+{
+	mockSwapchain * sc = (mockSwapchain *)(uintptr_t)swapchain;
+	*count = MOCK_SWAPCHAIN_LENGTH;
+	if (capacity == 0) return XR_SUCCESS;
+	if (capacity < MOCK_SWAPCHAIN_LENGTH) return XR_ERROR_SIZE_INSUFFICIENT;
+	mockSwapchainImageGL * gli = (mockSwapchainImageGL *)images;
+	for (int i = 0; i < MOCK_SWAPCHAIN_LENGTH; i++) gli[i].image = sc->images[i];
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo * info, uint32_t * index)
+{
+	mockSwapchain * sc = (mockSwapchain *)(uintptr_t)swapchain;
+	if (sc->acquired) return XR_ERROR_CALL_ORDER_INVALID;
+	sc->acquired = 1;
+	*index = sc->nextImage;
+	sc->nextImage = (sc->nextImage + 1) % MOCK_SWAPCHAIN_LENGTH;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo * info)
+{
+	mockSwapchain * sc = (mockSwapchain *)(uintptr_t)swapchain;
+	return sc->acquired ? XR_SUCCESS : XR_ERROR_CALL_ORDER_INVALID;
+}
+
+static XrResult XRAPI_CALL MockReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo * info)
+{
+	mockSwapchain * sc = (mockSwapchain *)(uintptr_t)swapchain;
+	if (!sc->acquired) return XR_ERROR_CALL_ORDER_INVALID;
+	sc->acquired = 0;
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Actions and synthetic controller input
+//------------------------------------------------------------------------------------
+
+static XrResult XRAPI_CALL MockCreateActionSet(XrInstance instance, const XrActionSetCreateInfo * info, XrActionSet * set)
+{
+	*set = (XrActionSet)(uintptr_t)calloc(1, 1);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroyActionSet(XrActionSet set)
+{
+	free((void *)(uintptr_t)set);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockCreateAction(XrActionSet set, const XrActionCreateInfo * info, XrAction * action)
+{
+	mockAction * a = calloc(1, sizeof(mockAction));
+	a->type = info->actionType;
+	snprintf(a->name, sizeof(a->name), "%s", info->actionName);
+	*action = (XrAction)(uintptr_t)a;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockDestroyAction(XrAction action)
+{
+	free((void *)(uintptr_t)action);
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockSuggestInteractionProfileBindings(XrInstance instance, const XrInteractionProfileSuggestedBinding * bindings)
+{
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockAttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo * info)
+{
+	return XR_SUCCESS;
+}
+
+static XrTime mockLastSync;
+
+static XrResult XRAPI_CALL MockSyncActions(XrSession session, const XrActionsSyncInfo * info)
+{
+	mockLastSync = MockNow();
+	return mock.state == XR_SESSION_STATE_FOCUSED ? XR_SUCCESS : XR_SESSION_NOT_FOCUSED;
+}
+
+static XrResult XRAPI_CALL MockGetActionStateBoolean(XrSession session, const XrActionStateGetInfo * info, XrActionStateBoolean * state)
+{
+	state->currentState = XR_FALSE;
+	state->changedSinceLastSync = XR_FALSE;
+	state->lastChangeTime = mock.epoch;
+	state->isActive = mock.state == XR_SESSION_STATE_FOCUSED;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetActionStateFloat(XrSession session, const XrActionStateGetInfo * info, XrActionStateFloat * state)
+{
+	float t = MockSeconds(mockLastSync);
+	int hand = MockHandFromPath(info->subactionPath);
+	state->currentState = 0.5f + 0.5f*sinf(t*0.8f + (hand > 0 ? 1.0f : 0.0f));
+	state->changedSinceLastSync = XR_TRUE;
+	state->lastChangeTime = mockLastSync;
+	state->isActive = mock.state == XR_SESSION_STATE_FOCUSED;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetActionStateVector2f(XrSession session, const XrActionStateGetInfo * info, XrActionStateVector2f * state)
+{
+	// left stick walks a slow circle, right stick gently turns back and forth
+	float t = MockSeconds(mockLastSync);
+	int hand = MockHandFromPath(info->subactionPath);
+	if (hand == 1)
+	{
+		state->currentState.x = 0.3f*sinf(t*0.25f);
+		state->currentState.y = 0.0f;
+	}
+	else
+	{
+		state->currentState.x = 0.6f*sinf(t*0.2f);
+		state->currentState.y = 0.6f*cosf(t*0.2f);
+	}
+	state->changedSinceLastSync = XR_TRUE;
+	state->lastChangeTime = mockLastSync;
+	state->isActive = mock.state == XR_SESSION_STATE_FOCUSED;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockGetActionStatePose(XrSession session, const XrActionStateGetInfo * info, XrActionStatePose * state)
+{
+	state->isActive = mock.state == XR_SESSION_STATE_FOCUSED;
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockApplyHapticFeedback(XrSession session, const XrHapticActionInfo * info, const XrHapticBaseHeader * haptic)
+{
+	return XR_SUCCESS;
+}
+
+static XrResult XRAPI_CALL MockStopHapticFeedback(XrSession session, const XrHapticActionInfo * info)
+{
+	return XR_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------------------------
+
+static XrResult XRAPI_CALL MockGetInstanceProcAddr(XrInstance instance, const char * name, PFN_xrVoidFunction * function);
+
+static XrResult XRAPI_CALL MockInitializeLoaderKHR(const void * info)
+{
+	return XR_SUCCESS;
+}
+
+static const struct
+{
+	const char * name;
+	PFN_xrVoidFunction function;
+} mockFunctions[] = {
+#define MOCK_FN(name, fn) { name, (PFN_xrVoidFunction)fn }
+	MOCK_FN("xrGetInstanceProcAddr", MockGetInstanceProcAddr),
+	MOCK_FN("xrInitializeLoaderKHR", MockInitializeLoaderKHR),
+	MOCK_FN("xrEnumerateInstanceExtensionProperties", MockEnumerateInstanceExtensionProperties),
+	MOCK_FN("xrCreateInstance", MockCreateInstance),
+	MOCK_FN("xrDestroyInstance", MockDestroyInstance),
+	MOCK_FN("xrGetInstanceProperties", MockGetInstanceProperties),
+	MOCK_FN("xrResultToString", MockResultToString),
+	MOCK_FN("xrPollEvent", MockPollEvent),
+	MOCK_FN("xrStringToPath", MockStringToPath),
+	MOCK_FN("xrPathToString", MockPathToString),
+	MOCK_FN("xrGetSystem", MockGetSystem),
+	MOCK_FN("xrGetSystemProperties", MockGetSystemProperties),
+	MOCK_FN("xrEnumerateViewConfigurationViews", MockEnumerateViewConfigurationViews),
+	MOCK_FN("xrGetOpenGLGraphicsRequirementsKHR", MockGetOpenGLGraphicsRequirementsKHR),
+	MOCK_FN("xrGetOpenGLESGraphicsRequirementsKHR", MockGetOpenGLESGraphicsRequirementsKHR),
+	MOCK_FN("xrCreateSession", MockCreateSession),
+	MOCK_FN("xrDestroySession", MockDestroySession),
+	MOCK_FN("xrBeginSession", MockBeginSession),
+	MOCK_FN("xrEndSession", MockEndSession),
+	MOCK_FN("xrRequestExitSession", MockRequestExitSession),
+	MOCK_FN("xrWaitFrame", MockWaitFrame),
+	MOCK_FN("xrBeginFrame", MockBeginFrame),
+	MOCK_FN("xrEndFrame", MockEndFrame),
+	MOCK_FN("xrEnumerateReferenceSpaces", MockEnumerateReferenceSpaces),
+	MOCK_FN("xrCreateReferenceSpace", MockCreateReferenceSpace),
+	MOCK_FN("xrCreateActionSpace", MockCreateActionSpace),
+	MOCK_FN("xrDestroySpace", MockDestroySpace),
+	MOCK_FN("xrLocateSpace", MockLocateSpace),
+	MOCK_FN("xrLocateViews", MockLocateViews),
+	MOCK_FN("xrEnumerateSwapchainFormats", MockEnumerateSwapchainFormats),
+	MOCK_FN("xrCreateSwapchain", MockCreateSwapchain),
+	MOCK_FN("xrDestroySwapchain", MockDestroySwapchain),
+	MOCK_FN("xrEnumerateSwapchainImages", MockEnumerateSwapchainImages),
+	MOCK_FN("xrAcquireSwapchainImage", MockAcquireSwapchainImage),
+	MOCK_FN("xrWaitSwapchainImage", MockWaitSwapchainImage),
+	MOCK_FN("xrReleaseSwapchainImage", MockReleaseSwapchainImage),
+	MOCK_FN("xrCreateActionSet", MockCreateActionSet),
+	MOCK_FN("xrDestroyActionSet", MockDestroyActionSet),
+	MOCK_FN("xrCreateAction", MockCreateAction),
+	MOCK_FN("xrDestroyAction", MockDestroyAction),
+	MOCK_FN("xrSuggestInteractionProfileBindings", MockSuggestInteractionProfileBindings),
+	MOCK_FN("xrAttachSessionActionSets", MockAttachSessionActionSets),
+	MOCK_FN("xrSyncActions", MockSyncActions),
+	MOCK_FN("xrGetActionStateBoolean", MockGetActionStateBoolean),
+	MOCK_FN("xrGetActionStateFloat", MockGetActionStateFloat),
+	MOCK_FN("xrGetActionStateVector2f", MockGetActionStateVector2f),
+	MOCK_FN("xrGetActionStatePose", MockGetActionStatePose),
+	MOCK_FN("xrApplyHapticFeedback", MockApplyHapticFeedback),
+	MOCK_FN("xrStopHapticFeedback", MockStopHapticFeedback),
+#undef MOCK_FN
+};
+
+static XrResult XRAPI_CALL MockGetInstanceProcAddr(XrInstance instance, const char * name, PFN_xrVoidFunction * function)
+{
+	for (size_t i = 0; i < sizeof(mockFunctions)/sizeof(mockFunctions[0]); i++)
+	{
+		if (!strcmp(name, mockFunctions[i].name))
+		{
+			*function = mockFunctions[i].function;
+			return XR_SUCCESS;
+		}
+	}
+	*function = NULL;
+	return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+MOCK_EXPORT XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(const XrNegotiateLoaderInfo * loaderInfo, XrNegotiateRuntimeRequest * runtimeRequest)
+{
+	if (!loaderInfo || !runtimeRequest ||
+		loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+		loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION ||
+		loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+		runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST ||
+		runtimeRequest->structVersion != XR_RUNTIME_INFO_STRUCT_VERSION ||
+		runtimeRequest->structSize != sizeof(XrNegotiateRuntimeRequest) ||
+		loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+		loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION)
+	{
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+
+	runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+	runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+	runtimeRequest->getInstanceProcAddr = MockGetInstanceProcAddr;
+	return XR_SUCCESS;
+}
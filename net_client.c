@@ -1,5 +1,7 @@
 #include "net/net_client.h"
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #define ENET_IMPLEMENTATION
 #include "net/net_common.h"
@@ -15,42 +17,124 @@ ENetPeer* server = { 0 };
 // the client peer we are using
 ENetHost* client = { 0 };
 
+// from the last AcceptPlayer, connecting with it after a drop gets our slot back if the server still has it
+uint32_t ResumeToken = 0;
+
+// what we connect with, kept so a stale resume can go straight back in as a new player
+JoinRequest LastJoin = { 0 };
+
 // how long in seconds since the last time we sent an update
 double LastInputSend = -100;
 
-// how long to wait between updates (20 update ticks a second)
+// the least time between updates, follows what the link to the server can take (see LinkRate).
+// starts at 20 a second and can go anywhere from every tick down to INPUT_MIN_RATE
 double InputUpdateInterval = 1.0f / 20.0f;
+LinkRate ServerLink = { 0 };
+#define INPUT_MIN_RATE 10
+#define INPUT_MAX_RATE 60
+// the biggest UpdateInput, what the rate gets worked out from
+#define INPUT_MAX_SIZE (21 + POSE_MAX_SIZE)
+
+// dead reckoning. everyone else (server included) guesses where we are from the last position and velocity we sent,
+// so we run the same guess here and only send when it's wrong by more than this, or we start or stop moving
+#define DR_POSITION_THRESHOLD 0.05f
+// slower than this counts as standing still
+#define DR_MOVING_SPEED 0.05f
+// even when the guess is right, send this often so everyone knows we're still here
+#define DR_KEEPALIVE 1.0
+// stop guessing this long after the last update from someone, they're more likely gone than still walking
+#define DR_MAX_EXTRAPOLATION (2.0 * DR_KEEPALIVE)
+
+// when an update moves a bean, it slides over to the new guess across about as long as updates for it have been
+// taking to come, so far away beans (which the server sends less often) don't jump. gaps longer than the max
+// are someone standing still and don't count
+#define SMOOTH_START_SPACING 0.1f
+#define SMOOTH_MIN_SPACING (1.0f / 60.0f)
+#define SMOOTH_MAX_SPACING 0.5f
+
+// what we sent last and when, the guess starts from here
+Vector3 SentPosition = { 0 };
+Vector3 SentVelocity = { 0 };
 
 double LastNow = 0;
 
+// the local pose as everyone else last heard it, only parts that moved past the thresholds in net_pose.h get sent again
+PlayerPose SentPose = { 0 };
+bool SendWholePose = true;
+
+// how many times we've respawned, the server only lets us jump (instead of sweeping) when this changes
+uint8_t RespawnCount = 0;
+// the count from the last CorrectPosition, the server ignores where updates from before it say we are
+uint8_t CorrectionCount = 0;
+// we jumped somewhere (a respawn or a correction), the next update goes out right away
+bool SendJump = false;
+
+// our attributes changed (or the server hasn't heard them yet) and need a PlayerAttributes sent
+bool SendAttributes = false;
+uint16_t AttributesRevision = 0;
+
+// what a bean looks like before its attributes arrive
+#define DEFAULT_R 128
+#define DEFAULT_G 128
+#define DEFAULT_B 128
+#define DEFAULT_A 255
+
 // this struct wont be used until networking is added
 typedef struct Bean {
     Vector3 position; // player position
+    Vector3 velocity; // in meters a second, as of updateTime
+    Vector3 correction; // where it was drawn minus where the update put it, shrinks to nothing over spacing
+    float spacing; // about how long between updates for this bean
     unsigned char r; // replacements
     unsigned char g; // for
     unsigned char b; // color
     unsigned char a; // type
+    uint16_t revision; // of the attributes above, older ones get ignored
+    bool hasAttributes;
+    PlayerPose pose; // head and hands, in the bean's frame
     bool active; // are they awake
     double updateTime; // time of last update
 } Bean;
 
 Bean beans[MAX_PLAYERS] = { 0 };
 
-// Connect to a server
-void Connect(const char* serverAddress)
+// Connect to a server, or back to it after the connection dropped
+void Connect(const char* serverAddress, Color color, int spawn)
 {
-	// startup the network library
-	enet_initialize();
+	// startup the network library and create a client that we will use to connect to the server.
+	// both stay around until Disconnect, reconnecting just makes a new connection on the same host
+	if (client == NULL)
+	{
+		enet_initialize();
+		client = enet_host_create(NULL, 1, 1, 0, 0);
+	}
 
-	// create a client that we will use to connect to the server
-	client = enet_host_create(NULL, 1, 1, 0, 0);
+	// whatever is left of the old connection
+	if (server != NULL)
+		enet_peer_reset(server);
 
 	// set the address and port we will connect to
 	enet_address_set_host(&address, serverAddress);
 	address.port = 4545;
 
 	// start the connection process. Will be finished as part of our update
-	server = enet_host_connect(client, &address, 1, 0);
+	// everything the server needs to let us in is in the connect, so the accept and the world come straight back.
+	// the token (0 the first time) asks for our old slot back instead, then we carry on where we were
+	LastJoin = (JoinRequest){ PROTOCOL_VERSION, ResumeToken, spawn, color };
+	server = enet_host_connect(client, &address, 1, PackJoinRequest(&LastJoin));
+}
+
+// Try the last connect again, asking for our slot back if we still have a token or joining fresh with the same color if not
+void Reconnect()
+{
+	if (client == NULL)
+		return;
+
+	if (server != NULL)
+		enet_peer_reset(server);
+
+	LastJoin.resumeToken = ResumeToken;
+	server = enet_host_connect(client, &address, 1, PackJoinRequest(&LastJoin));
 }
 
 Vector3 ReadPosition(ENetPacket* packet, size_t* offset)
@@ -66,24 +150,35 @@ Vector3 ReadPosition(ENetPacket* packet, size_t* offset)
 // A new remote player was added to our local simulation
 void HandleAddPlayer(ENetPacket* packet, size_t* offset)
 {
-	// find out who the server is talking about
+	// find out who the server is talking about, and read the whole message before deciding, more can follow it in the packet
 	int remotePlayer = ReadByte(packet, offset);
+	Vector3 position = ReadPosition(packet, offset);
+	Vector3 velocity = ReadVelocity(packet, offset);
+	PlayerPose pose;
+	ResetPose(&pose);
+	ReadPose(packet, offset, &pose);
 	if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId)
 		return;
 
 	// set them as active and update the location
 	printf("Bean %d added\n", remotePlayer);
-	beans[remotePlayer].position = ReadPosition(packet, offset);
-    beans[remotePlayer].r = ReadByte(packet, offset);
-    beans[remotePlayer].g = ReadByte(packet, offset);
-    beans[remotePlayer].b = ReadByte(packet, offset);
-    beans[remotePlayer].a = ReadByte(packet, offset);
+	beans[remotePlayer].position = position;
+	beans[remotePlayer].velocity = velocity;
+	beans[remotePlayer].correction = (Vector3){ 0 };
+	beans[remotePlayer].spacing = SMOOTH_START_SPACING;
+	beans[remotePlayer].pose = pose;
+	if (!beans[remotePlayer].hasAttributes)
+	{
+		beans[remotePlayer].r = DEFAULT_R;
+		beans[remotePlayer].g = DEFAULT_G;
+		beans[remotePlayer].b = DEFAULT_B;
+		beans[remotePlayer].a = DEFAULT_A;
+	}
     beans[remotePlayer].active = true;
 	beans[remotePlayer].updateTime = LastNow;
 	printf("Bean %d position: x=%f, y=%f, z=%f\n", remotePlayer, beans[remotePlayer].position.x, beans[remotePlayer].position.y, beans[remotePlayer].position.z);
 
-	// In a more robust game, this message would have more info about the new player, such as what sprite or model to use, player name, or other data a client would need
-	// this is where static data about the player would be sent, and any initial state needed to setup the local simulation
+	// static data about the player (color, later name and avatar) comes in PlayerAttributes, which can get here before or after this
 }
 
 // A remote player has left the game and needs to be removed from the local simulation
@@ -97,29 +192,83 @@ void HandleRemovePlayer(ENetPacket* packet, size_t* offset)
 	// remove the player from the simulation. No other data is needed except the player id
 	printf("Bean %d removed\n", remotePlayer); // they may be black
 	beans[remotePlayer].active = false;
+	beans[remotePlayer].hasAttributes = false;
 }
 
 // The server has a new position for a player in our local simulation
 void HandleUpdatePlayer(ENetPacket* packet, size_t* offset)
 {
-	// find out who the server is talking about
+	// find out who the server is talking about, the whole message gets read even if it's thrown away, more can follow it
 	int remotePlayer = ReadByte(packet, offset);
-	if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId || !beans[remotePlayer].active)
+	Vector3 position = ReadPosition(packet, offset);
+	Vector3 velocity = ReadVelocity(packet, offset);
+	bool valid = remotePlayer < MAX_PLAYERS && remotePlayer != LocalPlayerId && beans[remotePlayer].active;
+
+	// the pose only has the parts that changed, so they go on top of what we had
+	PlayerPose pose;
+	if (valid)
+		pose = beans[remotePlayer].pose;
+	ReadPose(packet, offset, &pose);
+	if (!valid)
 		return;
 
-	// update the last known position and movement
+	// update the last known position and movement, starting from wherever it's being drawn right now
 	//printf("Bean %d update\n", remotePlayer);
-	beans[remotePlayer].position = ReadPosition(packet, offset);
-	beans[remotePlayer].r = ReadByte(packet, offset);
-    beans[remotePlayer].g = ReadByte(packet, offset);
-    beans[remotePlayer].b = ReadByte(packet, offset);
-    beans[remotePlayer].a = ReadByte(packet, offset);
-	beans[remotePlayer].updateTime = LastNow;
+	Bean* bean = &beans[remotePlayer];
+	Vector3 drawn;
+	GetPlayerPos(remotePlayer, &drawn);
+	float gap = (float)(LastNow - bean->updateTime);
+	if (gap < SMOOTH_MAX_SPACING)
+		bean->spacing += (gap - bean->spacing) * 0.25f;
+
+	bean->position = position;
+	bean->velocity = velocity;
+	bean->correction = Vector3Subtract(drawn, position);
+	bean->pose = pose;
+	bean->updateTime = LastNow;
 
 	// in a more robust game this message would have a tick ID for what time this information was valid, and extra info about
 	// what the input state was so the local simulation could do prediction and smooth out the motion
 }
 
+// A player's color (and whatever else gets added) changed, or we just joined and are hearing about them
+void HandlePlayerAttributes(ENetPacket* packet, size_t* offset)
+{
+	int remotePlayer = ReadByte(packet, offset);
+	uint16_t revision = (uint16_t)ReadShort(packet, offset);
+	uint8_t r = ReadByte(packet, offset);
+	uint8_t g = ReadByte(packet, offset);
+	uint8_t b = ReadByte(packet, offset);
+	uint8_t a = ReadByte(packet, offset);
+	if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId)
+		return;
+
+	// kept even if they haven't been added yet, the add doesn't carry any of this
+	if (beans[remotePlayer].hasAttributes && (int16_t)(revision - beans[remotePlayer].revision) <= 0)
+		return;
+
+	beans[remotePlayer].revision = revision;
+	beans[remotePlayer].r = r;
+	beans[remotePlayer].g = g;
+	beans[remotePlayer].b = b;
+	beans[remotePlayer].a = a;
+	beans[remotePlayer].hasAttributes = true;
+}
+
+// The server's sweep of our last move ended somewhere else than ours did, everyone else sees us there so we go there too
+void HandleCorrectPosition(ENetPacket* packet, size_t* offset)
+{
+	uint8_t count = ReadByte(packet, offset);
+	Vector3 position = ReadPosition(packet, offset);
+
+	// the server moved on from there already, tell it we heard with the next update
+	CorrectionCount = count;
+	SendJump = true;
+	beans[LocalPlayerId].position = position;
+	printf("Corrected to x=%f, y=%f, z=%f\n", position.x, position.y, position.z);
+	CorrectTheBigBean(position);
+}
+
 // process one frame of updates
 void Update(double now, float deltaT)
 {
@@ -128,25 +277,60 @@ void Update(double now, float deltaT)
 	if (server == NULL)
 		return;
 
-	// Check if we have been accepted, and if so, check the clock to see if it is time for us to send the updated position for the local player
-	// we do this so that we don't spam the server with updates 60 times a second and waste bandwidth
-	// in a real game we'd send our normalized movement vector or input keys along with what the current tick index was
-	// this way the server can know how long it's been since the last update and can do interpolation to know were we are between updates.
-	if (LocalPlayerId >= 0 && now - LastInputSend > InputUpdateInterval)
+	// back off when the link to the server gets worse, and tell enet so its throttle agrees
+	if (LocalPlayerId >= 0)
 	{
-		// Pack up a buffer with the data we want to send
-		uint8_t buffer[17] = { 0 }; // 10 bytes for a 1 byte command number and two bytes for each X and Y value
+		UpdateLinkRate(&ServerLink, server, now, INPUT_MIN_RATE, INPUT_MAX_RATE, INPUT_MAX_SIZE);
+		InputUpdateInterval = ServerLink.interval;
+		if (client->outgoingBandwidth != ServerLink.bandwidth)
+			enet_host_bandwidth_limit(client, 0, ServerLink.bandwidth);
+	}
+
+	// Check if we have been accepted, and if so, whether anyone would notice if we didn't send anything.
+	// most of the time a player is standing around or walking in a straight line and the guess is right, so nothing goes out
+	// except the keepalive. starting and stopping always go out right away, or the guess would run off or lag behind
+	const Bean* local = LocalPlayerId >= 0 ? &beans[LocalPlayerId] : NULL;
+	bool moving = local && Vector3Length(local->velocity) > DR_MOVING_SPEED;
+	bool wasMoving = Vector3Length(SentVelocity) > DR_MOVING_SPEED;
+	bool startStop = local && moving != wasMoving;
+	bool drifted = local && Vector3Distance(Vector3Add(SentPosition, Vector3Scale(SentVelocity, (float)(now - LastInputSend))), local->position) > DR_POSITION_THRESHOLD;
+	uint8_t parts = !local ? 0 : SendWholePose ? POSE_ALL : GetPoseChanges(&SentPose, &local->pose);
+	bool due = now - LastInputSend > InputUpdateInterval && (drifted || parts != 0);
+	if (local && (SendJump || startStop || due || now - LastInputSend > DR_KEEPALIVE))
+	{
+		// Pack up a buffer with the data we want to send, only what changes from tick to tick, the color goes in PlayerAttributes
+		uint8_t buffer[INPUT_MAX_SIZE] = { 0 }; // 1 byte command, 3 floats of position, 3 shorts of velocity, respawn and correction counts, then the pose
 		buffer[0] = (uint8_t)UpdateInput;   // this tells the server what kind of data to expect in this packet
-		*(float*)(buffer + 1) = (float)beans[LocalPlayerId].position.x;
-		*(float*)(buffer + 5) = (float)beans[LocalPlayerId].position.y;
-		*(float*)(buffer + 9) = (float)beans[LocalPlayerId].position.z;
-		*(uint8_t*)(buffer + 13) = (uint8_t)beans[LocalPlayerId].r;
-		*(uint8_t*)(buffer + 14) = (uint8_t)beans[LocalPlayerId].g;
-		*(uint8_t*)(buffer + 15) = (uint8_t)beans[LocalPlayerId].b;
-		*(uint8_t*)(buffer + 16) = (uint8_t)beans[LocalPlayerId].a;
+		*(float*)(buffer + 1) = (float)local->position.x;
+		*(float*)(buffer + 5) = (float)local->position.y;
+		*(float*)(buffer + 9) = (float)local->position.z;
+		WriteVelocity(buffer + 13, local->velocity);
+
+		// the guess starts over from what the server is about to hear. standing still sends exactly zero so nobody creeps
+		SentPosition = local->position;
+		SentVelocity = moving ? UnpackVelocity(buffer + 13) : (Vector3){ 0 };
+		if (!moving) WriteVelocity(buffer + 13, SentVelocity);
+
+		// only what moved enough to notice, updates are reliable so the server's copy stays in step with SentPose
+		const PlayerPose* pose = &local->pose;
+		buffer[19] = RespawnCount;
+		buffer[20] = CorrectionCount;
+		SendJump = false;
+		size_t size = 21 + WritePose(buffer + 21, pose, parts);
+		if (parts & POSE_ROTATION) SentPose.rotation = pose->rotation;
+		if (parts & POSE_HEAD) SentPose.head = pose->head;
+		for (int i = 0; i < 2; i++)
+		{
+			if (!(parts & (POSE_LEFT << i)))
+				continue;
+			SentPose.handPosition[i] = pose->handPosition[i];
+			SentPose.handRotation[i] = pose->handRotation[i];
+		}
+		SentPose.tracked = pose->tracked;
+		SendWholePose = false;
 
         // copy this data into a packet provided by enet (TODO : add pack functions that write directly to the packet to avoid the copy)
-		ENetPacket* packet = enet_packet_create(buffer, 17, ENET_PACKET_FLAG_RELIABLE);
+		ENetPacket* packet = enet_packet_create(buffer, size, ENET_PACKET_FLAG_RELIABLE);
 
 		// send the packet to the server
 		enet_peer_send(server, 0, packet);
@@ -158,10 +342,24 @@ void Update(double now, float deltaT)
 		LastInputSend = now;
     }
 
-    // read one event from enet and process it
+	// attributes go out as soon as they change, not on the input clock, they're rare and people should see them right away
+	if (LocalPlayerId >= 0 && SendAttributes)
+	{
+		uint8_t buffer[7] = { 0 };
+		buffer[0] = (uint8_t)PlayerAttributes;
+		*(uint16_t*)(buffer + 1) = AttributesRevision;
+		buffer[3] = beans[LocalPlayerId].r;
+		buffer[4] = beans[LocalPlayerId].g;
+		buffer[5] = beans[LocalPlayerId].b;
+		buffer[6] = beans[LocalPlayerId].a;
+		enet_peer_send(server, 0, enet_packet_create(buffer, 7, ENET_PACKET_FLAG_RELIABLE));
+		SendAttributes = false;
+	}
+
+    // read every event enet has for us and process them, anything left for the next tick is just late
 	ENetEvent Event = { 0 };
 
-    if (enet_host_service(client, &Event, 0) > 0)
+    while (client != NULL && enet_host_service(client, &Event, 0) > 0)
 	{
 		// see what kind of event it is
 		switch (Event.type)
@@ -184,9 +382,13 @@ void Update(double now, float deltaT)
 				{
 					if (command == AcceptPlayer)    // this is the only thing we can do in this state, so ignore anything else
 					{
-						// See who the server says we are
+						// See who the server says we are, if it still had our slot from before a drop, and where it put us
 						LocalPlayerId = ReadByte(Event.packet, &offset);
-						printf("Local ID = %d\n", LocalPlayerId);
+						ResumeToken = ReadUInt(Event.packet, &offset);
+						bool resumed = ReadByte(Event.packet, &offset);
+						Vector3 spawnPosition = ReadPosition(Event.packet, &offset);
+						float spawnYaw = ReadFloat(Event.packet, &offset);
+						printf("Local ID = %d%s\n", LocalPlayerId, resumed ? " (resumed)" : "");
 
 						// Make sure that it makes sense
 						if (LocalPlayerId < 0 || LocalPlayerId > MAX_PLAYERS)
@@ -196,36 +398,71 @@ void Update(double now, float deltaT)
 						}
 
 						// Force the next frame to do an update by pretending it's been a very long time since our last update
+						InitLinkRate(&ServerLink, now, INPUT_MAX_RATE);
+						InputUpdateInterval = ServerLink.interval;
 						LastInputSend = -InputUpdateInterval;
 
+						// anything changed while we were away comes as usual, and the color in case it changed.
+						// when resuming the server still has the rest, our position, pose and everyone else, so there's nothing to start over
+						SendAttributes = resumed;
+						if (!resumed)
+						{
+							// a new player, everyone we knew about is from some other game. the world is in the snapshot right behind this.
+							// our own color goes too, so the next UpdatePlayerAttributes sends the exact one (the connect only had it rounded)
+							memset(beans, 0, sizeof(beans));
+
+							// the server has no pose for us yet, and counts our respawns and corrections from 0
+							SendWholePose = true;
+							RespawnCount = 0;
+							CorrectionCount = 0;
+							SendJump = false;
+
+							// the server picked our spawn point and everyone is already seeing us there
+							beans[LocalPlayerId].position = spawnPosition;
+							UpdateTheBigBean(spawnPosition, Vector3Add(spawnPosition, (Vector3){ -sinf(spawnYaw), 0.0f, -cosf(spawnYaw) }));
+						}
+
 						// We are active
 						beans[LocalPlayerId].active = true;
-
-						// Set our player at some location on the field.
-						// optimally we would do a much more robust connection negotiation where we tell the server what our name is, what we look like
-						// and then the server tells us where we are
-						// But for this simple test, everyone starts at the same place on the field
-						beans[LocalPlayerId].position = (Vector3){ 0.0f, 1.7f, 4.0f };    // Camera position
-                        //bean->target = (Vector3){ 0.0f, 1.7f, 0.0f };      // Camera looking at point
-                        UpdateTheBigBean(beans[LocalPlayerId].position, (Vector3){ 0.0f, 1.7f, 0.0f });
 					}
 				}
                 else // we have been accepted, so process play messages from the server
 				{
-					// see what the server wants us to do
-					switch (command)
+					// a snapshot is several messages back to back, keep going until the packet runs out or we don't know one
+					bool known = true;
+					while (known)
 					{
-						case AddPlayer:
-							HandleAddPlayer(Event.packet, &offset);
-							break;
+						// see what the server wants us to do
+						switch (command)
+						{
+							case AddPlayer:
+								HandleAddPlayer(Event.packet, &offset);
+								break;
 
-						case RemovePlayer:
-							HandleRemovePlayer(Event.packet, &offset);
-							break;
+							case RemovePlayer:
+								HandleRemovePlayer(Event.packet, &offset);
+								break;
+
+							case UpdatePlayer:
+								HandleUpdatePlayer(Event.packet, &offset);
+								break;
 
-						case UpdatePlayer:
-							HandleUpdatePlayer(Event.packet, &offset);
+							case PlayerAttributes:
+								HandlePlayerAttributes(Event.packet, &offset);
+								break;
+
+							case CorrectPosition:
+								HandleCorrectPosition(Event.packet, &offset);
+								break;
+
+							default:
+								known = false;
+								break;
+						}
+
+						if (offset >= Event.packet->dataLength)
 							break;
+						command = (NetworkCommands)ReadByte(Event.packet, &offset);
 					}
 				}
 				// tell enet that it can recycle the packet data
@@ -233,10 +470,23 @@ void Update(double now, float deltaT)
 				break;
 			}
 
-            // we were disconnected, we have a sad
+            // we were disconnected, we have a sad. everyone stays where they were until we're back (or find out we aren't).
+			// a dropped link (and a connect nobody answered) comes as a timeout, enet has already reset the peer either way
+			case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
 			case ENET_EVENT_TYPE_DISCONNECT:
+				if (Event.data == DISCONNECT_VERSION)
+					printf("The server speaks a different protocol version\n");
 				server = NULL;
 				LocalPlayerId = -1;
+
+				// our slot is gone, join again with everything a new player needs
+				if (Event.data == DISCONNECT_STALE_RESUME)
+				{
+					printf("Couldn't resume, joining again\n");
+					ResumeToken = 0;
+					LastJoin.resumeToken = 0;
+					server = enet_host_connect(client, &address, 1, PackJoinRequest(&LastJoin));
+				}
 				break;
 		}
 	}
@@ -245,9 +495,12 @@ void Update(double now, float deltaT)
 // force a disconnect by shutting down enet
 void Disconnect()
 {
-	// close our connection to the server
+	// close our connection to the server, telling it we quit so it doesn't hold our slot
 	if (server != NULL)
-		enet_peer_disconnect(server, 0);
+	{
+		enet_peer_disconnect(server, DISCONNECT_QUIT);
+		enet_host_flush(client);
+	}
 
 	// close our client
 	if (client != NULL)
@@ -255,6 +508,7 @@ void Disconnect()
 
 	client = NULL;
 	server = NULL;
+	ResumeToken = 0;
 
 	// clean up enet
 	enet_deinitialize();
@@ -266,6 +520,11 @@ bool Connected()
 	return server != NULL && LocalPlayerId >= 0;
 }
 
+bool Connecting()
+{
+	return server != NULL && LocalPlayerId < 0;
+}
+
 int GetLocalPlayerId()
 {
 	return LocalPlayerId;
@@ -278,7 +537,30 @@ bool GetPlayerPos(int id, Vector3* pos)
 	if (id < 0 || id >= MAX_PLAYERS || !beans[id].active)
 		return false;
 
-	*pos = beans[id].position;
+	// carry them along the way they were going, the same guess their client is checking itself against,
+	// plus whatever's left of the slide over from where they were drawn before the last update
+	const Bean* bean = &beans[id];
+	double elapsed = LastNow - bean->updateTime;
+	if (id == LocalPlayerId || elapsed <= 0.0)
+	{
+		*pos = id == LocalPlayerId ? bean->position : Vector3Add(bean->position, bean->correction);
+		return true;
+	}
+
+	float spacing = bean->spacing > SMOOTH_MIN_SPACING ? bean->spacing : SMOOTH_MIN_SPACING;
+	float left = 1.0f - (float)elapsed / spacing;
+	*pos = Vector3Add(bean->position, Vector3Scale(bean->velocity, (float)fmin(elapsed, DR_MAX_EXTRAPOLATION)));
+	if (left > 0.0f)
+		*pos = Vector3Add(*pos, Vector3Scale(bean->correction, left));
+	return true;
+}
+
+bool GetPlayerPose(int id, PlayerPose* pose)
+{
+	if (id < 0 || id >= MAX_PLAYERS || !beans[id].active)
+		return false;
+
+	*pose = beans[id].pose;
 	return true;
 }
 
@@ -333,10 +615,40 @@ bool IsPlayerReal(int id) { // we could be a schizo
 	return true;
 }
 
-void UpdatePlayerList(Vector3 position, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+void UpdatePlayerList(Vector3 position, Vector3 velocity) {
     beans[LocalPlayerId].position = position;
-	beans[LocalPlayerId].r = r;
-    beans[LocalPlayerId].g = g;
-    beans[LocalPlayerId].b = b;
-    beans[LocalPlayerId].a = a;
+    beans[LocalPlayerId].velocity = velocity;
+}
+
+void UpdatePlayerAttributes(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	if (LocalPlayerId < 0)
+		return;
+
+	Bean* local = &beans[LocalPlayerId];
+	if (local->r == r && local->g == g && local->b == b && local->a == a)
+		return;
+
+	local->r = r;
+	local->g = g;
+	local->b = b;
+	local->a = a;
+	AttributesRevision++;
+	SendAttributes = true;
+}
+
+void TeleportPlayer(Vector3 position) {
+	if (LocalPlayerId < 0)
+		return;
+
+	beans[LocalPlayerId].position = position;
+	beans[LocalPlayerId].velocity = (Vector3){ 0 };
+	RespawnCount++;
+	SendJump = true;
+}
+
+void UpdatePlayerPose(const PlayerPose* pose) {
+	if (LocalPlayerId < 0)
+		return;
+
+	beans[LocalPlayerId].pose = *pose;
 }
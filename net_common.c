@@ -27,6 +27,8 @@
 **********************************************************************************************/
 
 #include "net/net_common.h"
+#include <math.h>
+#include <string.h>
 
 
 // Utility functions to read data out of a packet
@@ -94,3 +96,274 @@ float ReadFloat(ENetPacket* packet, size_t* offset)
 	return *(float*)data;
 }
 
+uint32_t ReadUInt(ENetPacket* packet, size_t* offset)
+{
+	if(*offset > packet->dataLength)
+		return 0;
+
+	uint8_t* data = (uint8_t*)packet->data;
+	data += (*offset);
+
+	*offset = (*offset) + 4;
+
+	return *(uint32_t*)data;
+}
+
+static int16_t PackVelocity(float v)
+{
+	float scaled = v * VELOCITY_SCALE;
+	if (scaled < -32767.0f) scaled = -32767.0f;
+	if (scaled > 32767.0f) scaled = 32767.0f;
+	return (int16_t)lrintf(scaled);
+}
+
+void WriteVelocity(uint8_t* buffer, Vector3 velocity)
+{
+	*(int16_t*)(buffer) = PackVelocity(velocity.x);
+	*(int16_t*)(buffer + 2) = PackVelocity(velocity.y);
+	*(int16_t*)(buffer + 4) = PackVelocity(velocity.z);
+}
+
+Vector3 UnpackVelocity(const uint8_t* buffer)
+{
+	return (Vector3){ *(const int16_t*)(buffer) / VELOCITY_SCALE, *(const int16_t*)(buffer + 2) / VELOCITY_SCALE, *(const int16_t*)(buffer + 4) / VELOCITY_SCALE };
+}
+
+Vector3 ReadVelocity(ENetPacket* packet, size_t* offset)
+{
+	Vector3 velocity = { 0 };
+	velocity.x = ReadShort(packet, offset) / VELOCITY_SCALE;
+	velocity.y = ReadShort(packet, offset) / VELOCITY_SCALE;
+	velocity.z = ReadShort(packet, offset) / VELOCITY_SCALE;
+	return velocity;
+}
+
+#define JOIN_VERSION_SHIFT 28
+#define JOIN_RESUME 0x08000000
+#define JOIN_SPAWN_SHIFT 24
+// the 3 spawn bits all set is SPAWN_ANY
+#define JOIN_SPAWN_ANY 7
+
+uint32_t PackJoinRequest(const JoinRequest* request)
+{
+	uint32_t data = (uint32_t)(request->version & 0x0f) << JOIN_VERSION_SHIFT;
+	if (request->resumeToken != 0)
+		return data | JOIN_RESUME | (request->resumeToken & RESUME_TOKEN_MASK);
+
+	uint32_t spawn = request->spawn >= 0 && request->spawn < JOIN_SPAWN_ANY ? (uint32_t)request->spawn : JOIN_SPAWN_ANY;
+	data |= spawn << JOIN_SPAWN_SHIFT;
+	data |= (uint32_t)(request->color.r >> 2) << 18 | (uint32_t)(request->color.g >> 2) << 12 | (uint32_t)(request->color.b >> 2) << 6 | (uint32_t)(request->color.a >> 2);
+	return data;
+}
+
+// 6 bits back to 8, so white stays white
+static unsigned char UnpackChannel(uint32_t bits)
+{
+	bits &= 0x3f;
+	return (unsigned char)(bits << 2 | bits >> 4);
+}
+
+void UnpackJoinRequest(uint32_t data, JoinRequest* request)
+{
+	request->version = (uint8_t)(data >> JOIN_VERSION_SHIFT);
+	request->resumeToken = (data & JOIN_RESUME) ? data & RESUME_TOKEN_MASK : 0;
+	request->spawn = SPAWN_ANY;
+	request->color = (Color){ 0 };
+	if (data & JOIN_RESUME)
+		return;
+
+	uint32_t spawn = (data >> JOIN_SPAWN_SHIFT) & 0x07;
+	request->spawn = spawn == JOIN_SPAWN_ANY ? SPAWN_ANY : (int)spawn;
+	request->color = (Color){ UnpackChannel(data >> 18), UnpackChannel(data >> 12), UnpackChannel(data >> 6), UnpackChannel(data) };
+}
+
+static void SetLinkRate(LinkRate* link, int minRate, int maxRate, uint32_t sendSize)
+{
+	// as often as the bandwidth allows full sends, then smaller sends once even the lowest rate doesn't fit
+	int rate = sendSize > 0 ? (int)(link->bandwidth / sendSize) : maxRate;
+	if (rate < minRate) rate = minRate;
+	if (rate > maxRate) rate = maxRate;
+	link->interval = 1.0 / rate;
+	link->budget = link->bandwidth / rate;
+}
+
+void InitLinkRate(LinkRate* link, double now, int maxRate)
+{
+	link->bandwidth = LINK_START_BANDWIDTH;
+	link->nextUpdate = now + LINK_UPDATE_PERIOD;
+	SetLinkRate(link, maxRate, maxRate, 0);
+}
+
+void UpdateLinkRate(LinkRate* link, ENetPeer* peer, double now, int minRate, int maxRate, uint32_t sendSize)
+{
+	if (now >= link->nextUpdate)
+	{
+		link->nextUpdate = now + LINK_UPDATE_PERIOD;
+
+		bool lossy = peer->packetLoss > LINK_MAX_LOSS;
+		bool queued = peer->roundTripTime > peer->lowestRoundTripTime + LINK_QUEUE_DELAY;
+		bool throttled = peer->packetThrottle < ENET_PEER_PACKET_THROTTLE_SCALE / 2;
+		if (lossy || queued || throttled)
+			link->bandwidth = link->bandwidth * 3 / 4;
+		else
+			link->bandwidth += LINK_BANDWIDTH_STEP;
+
+		if (link->bandwidth < LINK_MIN_BANDWIDTH) link->bandwidth = LINK_MIN_BANDWIDTH;
+		if (link->bandwidth > LINK_MAX_BANDWIDTH) link->bandwidth = LINK_MAX_BANDWIDTH;
+	}
+	SetLinkRate(link, minRate, maxRate, sendSize);
+}
+
+// the biggest a component other than the largest can be
+#define QUAT_COMPONENT_MAX 0.70710678f
+#define QUAT_COMPONENT_BITS 10
+#define QUAT_COMPONENT_STEPS ((1 << QUAT_COMPONENT_BITS) - 1)
+
+uint32_t PackQuaternion(Quaternion q)
+{
+	float c[4] = { q.x, q.y, q.z, q.w };
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+	{
+		if (fabsf(c[i]) > fabsf(c[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, flip it so the dropped one is positive and doesn't need a sign
+	float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	uint32_t packed = (uint32_t)largest;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+
+		float v = c[i] * sign;
+		if (v < -QUAT_COMPONENT_MAX) v = -QUAT_COMPONENT_MAX;
+		if (v > QUAT_COMPONENT_MAX) v = QUAT_COMPONENT_MAX;
+		uint32_t step = (uint32_t)((v + QUAT_COMPONENT_MAX) / (2.0f * QUAT_COMPONENT_MAX) * QUAT_COMPONENT_STEPS + 0.5f);
+		packed = (packed << QUAT_COMPONENT_BITS) | step;
+	}
+	return packed;
+}
+
+Quaternion UnpackQuaternion(uint32_t packed)
+{
+	int largest = (int)(packed >> (3 * QUAT_COMPONENT_BITS));
+	float c[4] = { 0 };
+	float sum = 0.0f;
+	for (int i = 3; i >= 0; i--)
+	{
+		if (i == largest)
+			continue;
+
+		uint32_t step = packed & QUAT_COMPONENT_STEPS;
+		packed >>= QUAT_COMPONENT_BITS;
+		c[i] = (float)step / QUAT_COMPONENT_STEPS * (2.0f * QUAT_COMPONENT_MAX) - QUAT_COMPONENT_MAX;
+		sum += c[i] * c[i];
+	}
+	c[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+	return (Quaternion){ c[0], c[1], c[2], c[3] };
+}
+
+void ResetPose(PlayerPose* pose)
+{
+	memset(pose, 0, sizeof(PlayerPose));
+	pose->rotation.w = 1.0f;
+	pose->head.w = 1.0f;
+	pose->handRotation[0].w = 1.0f;
+	pose->handRotation[1].w = 1.0f;
+}
+
+static bool RotationMoved(Quaternion a, Quaternion b)
+{
+	// the angle between them is 2 acos |a.b|, compared without the acos
+	float dot = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+	return dot < cosf(POSE_ANGLE_THRESHOLD * 0.5f);
+}
+
+static bool PositionMoved(Vector3 a, Vector3 b)
+{
+	float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz > POSE_POSITION_THRESHOLD * POSE_POSITION_THRESHOLD;
+}
+
+uint8_t GetPoseChanges(const PlayerPose* sent, const PlayerPose* now)
+{
+	uint8_t parts = 0;
+	if (RotationMoved(sent->rotation, now->rotation))
+		parts |= POSE_ROTATION;
+	if (RotationMoved(sent->head, now->head))
+		parts |= POSE_HEAD;
+
+	for (int i = 0; i < 2; i++)
+	{
+		uint8_t hand = POSE_LEFT << i;
+		if ((sent->tracked & hand) != (now->tracked & hand))
+			parts |= hand;
+		else if ((now->tracked & hand) && (PositionMoved(sent->handPosition[i], now->handPosition[i]) || RotationMoved(sent->handRotation[i], now->handRotation[i])))
+			parts |= hand;
+	}
+	return parts;
+}
+
+static int16_t PackOffset(float v)
+{
+	float scaled = v * POSE_POSITION_SCALE;
+	if (scaled < -32767.0f) scaled = -32767.0f;
+	if (scaled > 32767.0f) scaled = 32767.0f;
+	return (int16_t)lrintf(scaled);
+}
+
+size_t WritePose(uint8_t* buffer, const PlayerPose* pose, uint8_t parts)
+{
+	parts &= POSE_ALL;
+	size_t size = 0;
+	buffer[size++] = parts | (uint8_t)(pose->tracked << POSE_TRACKED_SHIFT);
+
+	if (parts & POSE_ROTATION)
+	{
+		*(uint32_t*)(buffer + size) = PackQuaternion(pose->rotation);
+		size += 4;
+	}
+	if (parts & POSE_HEAD)
+	{
+		*(uint32_t*)(buffer + size) = PackQuaternion(pose->head);
+		size += 4;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (!(parts & (POSE_LEFT << i)))
+			continue;
+
+		*(int16_t*)(buffer + size) = PackOffset(pose->handPosition[i].x);
+		*(int16_t*)(buffer + size + 2) = PackOffset(pose->handPosition[i].y);
+		*(int16_t*)(buffer + size + 4) = PackOffset(pose->handPosition[i].z);
+		*(uint32_t*)(buffer + size + 6) = PackQuaternion(pose->handRotation[i]);
+		size += 10;
+	}
+	return size;
+}
+
+uint8_t ReadPose(ENetPacket* packet, size_t* offset, PlayerPose* pose)
+{
+	uint8_t header = ReadByte(packet, offset);
+	uint8_t parts = header & POSE_ALL;
+	pose->tracked = (header >> POSE_TRACKED_SHIFT) & (POSE_LEFT | POSE_RIGHT);
+
+	if (parts & POSE_ROTATION)
+		pose->rotation = UnpackQuaternion(ReadUInt(packet, offset));
+	if (parts & POSE_HEAD)
+		pose->head = UnpackQuaternion(ReadUInt(packet, offset));
+	for (int i = 0; i < 2; i++)
+	{
+		if (!(parts & (POSE_LEFT << i)))
+			continue;
+
+		pose->handPosition[i].x = ReadShort(packet, offset) / POSE_POSITION_SCALE;
+		pose->handPosition[i].y = ReadShort(packet, offset) / POSE_POSITION_SCALE;
+		pose->handPosition[i].z = ReadShort(packet, offset) / POSE_POSITION_SCALE;
+		pose->handRotation[i] = UnpackQuaternion(ReadUInt(packet, offset));
+	}
+	return parts;
+}
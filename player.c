@@ -4,183 +4,149 @@
 #include "raylib/raymath.h"
 #include "net/net_client.h"
 #include <stdio.h>
+#include <math.h>
 
-void UpdateCameraWithBean(LocalBean* bean) {
-    if(bean->cameraMode == CAMERA_FIRST_PERSON) {
-        bean->camera.position = bean->transform.translation;
-        bean->camera.target = bean->target;
-        bean->camera.up = bean->up;
-    } else { // assume third person for time
-        Vector3 newCameraPosition = Vector3Negate(Vector3Subtract(bean->target, bean->transform.translation));
-        bean->camera.position = Vector3Add(bean->transform.translation, newCameraPosition);
-        bean->camera.target = bean->transform.translation;
-        bean->camera.up = bean->up;
-    }
+// speeds are per second now that movement runs on fixed ticks, these match the old per frame values at 60 fps
+#define BEAN_MOVE_SPEED 5.4f
+#define CAMERA_MOUSE_SPEED 0.003f
+#define CAMERA_ROTATION 1.8f
+#define GAMEPAD_LOOK_SPEED 0.36f
+#define GAMEPAD_DEADZONE 0.25f
+// just short of straight up and down so forward never lines up with the up vector
+#define BEAN_PITCH_LIMIT (89.0f * DEG2RAD)
+// how far behind the bean the third person camera sits
+#define BEAN_THIRD_PERSON_DISTANCE 4.0f
+// fall below this and you get put back on a spawn point
+#define BEAN_KILL_HEIGHT -50.0f
+
+static void UpdateBeanRotation(LocalBean* bean) {
+    // yaw around the world up, then pitch around the bean's own right
+    Quaternion yaw = QuaternionFromAxisAngle((Vector3){ 0.0f, 1.0f, 0.0f }, bean->yaw);
+    Quaternion pitch = QuaternionFromAxisAngle((Vector3){ 1.0f, 0.0f, 0.0f }, bean->pitch);
+    bean->transform.rotation = QuaternionMultiply(yaw, pitch);
+    bean->cameraDirty = true;
 }
 
 Vector3 GetBeanForward(LocalBean* bean) {
-    return Vector3Normalize(Vector3Subtract(bean->target, bean->transform.translation));
+    return Vector3RotateByQuaternion((Vector3){ 0.0f, 0.0f, -1.0f }, bean->transform.rotation);
 }
 
-Vector3 GetBeanUp(LocalBean* bean)
-{
-    return Vector3Normalize(bean->up);
-}
-
-Vector3 GetBeanRight(LocalBean* bean)
-{
-    Vector3 forward = GetBeanForward(bean);
-    Vector3 up = GetBeanUp(bean);
+void SetBeanLook(LocalBean* bean, Vector3 target) {
+    Vector3 look = Vector3Subtract(target, bean->transform.translation);
+    if (Vector3LengthSqr(look) < 1e-6f) return;
 
-    return Vector3CrossProduct(forward, up);
+    look = Vector3Normalize(look);
+    bean->yaw = atan2f(-look.x, -look.z);
+    bean->pitch = Clamp(asinf(look.y), -BEAN_PITCH_LIMIT, BEAN_PITCH_LIMIT);
+    UpdateBeanRotation(bean);
 }
 
-void BeanMoveForward(LocalBean* bean, float distance, bool moveInWorldPlane) {
-    Vector3 forward = GetBeanForward(bean);
+Camera GetBeanCamera(LocalBean* bean) {
+    if (!bean->cameraDirty) return bean->camera;
 
-    if (moveInWorldPlane)
-    {
-        // Project vector onto world plane
-        forward.y = 0;
-        forward = Vector3Normalize(forward);
+    Vector3 forward = GetBeanForward(bean);
+    if(bean->cameraMode == CAMERA_FIRST_PERSON) {
+        bean->camera.position = bean->transform.translation;
+        bean->camera.target = Vector3Add(bean->transform.translation, forward);
+    } else { // assume third person for time
+        bean->camera.position = Vector3Subtract(bean->transform.translation, Vector3Scale(forward, BEAN_THIRD_PERSON_DISTANCE));
+        bean->camera.target = bean->transform.translation;
     }
-
-    // Scale by distance
-    forward = Vector3Scale(forward, distance);
-
-    bean->posAdd = Vector3Add(bean->posAdd, forward);
-
-    bean->transform.translation = Vector3Add(bean->transform.translation, forward);
-    bean->target = Vector3Add(bean->target, forward);
-    UpdateCameraWithBean(bean);
+    bean->camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    bean->cameraDirty = false;
+    return bean->camera;
 }
 
-void BeanMoveRight(LocalBean* bean, float distance, bool moveInWorldPlane)
-{
-    Vector3 right = GetBeanRight(bean);
-
-    if (moveInWorldPlane)
-    {
-        // Project vector onto world plane
-        right.y = 0;
-        right = Vector3Normalize(right);
-    }
-
-    // Scale by distance
-    right = Vector3Scale(right, distance);
-
-    bean->posAdd = Vector3Add(bean->posAdd, right);
-
-    // Move position and target
-    bean->transform.translation = Vector3Add(bean->transform.translation, right);
-    bean->target = Vector3Add(bean->target, right);
-    UpdateCameraWithBean(bean);
+void GatherBeanLook(BeanIntent* intent) {
+    Vector2 mousePositionDelta = GetMouseDelta();
+    intent->yaw -= mousePositionDelta.x*CAMERA_MOUSE_SPEED;
+    intent->pitch -= mousePositionDelta.y*CAMERA_MOUSE_SPEED;
 }
 
-void BeanYaw(LocalBean* bean, float angle, bool rotateAroundTarget)
-{
-    // Rotation axis
-    Vector3 up = GetBeanUp(bean);
+void GatherBeanIntent(BeanIntent* intent, float dt) {
+    Vector2 move = { 0.0f, 0.0f };
+    float turn = CAMERA_ROTATION*dt;
 
-    // View vector
-    Vector3 targetPosition = Vector3Subtract(bean->target, bean->transform.translation);
+    if(IsKeyDown(KEY_DOWN)) intent->pitch -= turn;
+    if(IsKeyDown(KEY_UP)) intent->pitch += turn;
+    if(IsKeyDown(KEY_RIGHT)) intent->yaw -= turn;
+    if(IsKeyDown(KEY_LEFT)) intent->yaw += turn;
 
-    // Rotate view vector around up axis
-    targetPosition = Vector3RotateByAxisAngle(targetPosition, up, angle);
+    if (IsKeyDown(KEY_W)) move.y += 1.0f;
+    if (IsKeyDown(KEY_A)) move.x -= 1.0f;
+    if (IsKeyDown(KEY_S)) move.y -= 1.0f;
+    if (IsKeyDown(KEY_D)) move.x += 1.0f;
 
-    bean->target = Vector3Add(bean->transform.translation, targetPosition);
-    
-    UpdateCameraWithBean(bean);
-}
+    if (IsGamepadAvailable(0)) {
+        // Gamepad controller support
+        intent->yaw -= GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_X)*GAMEPAD_LOOK_SPEED*dt;
+        intent->pitch -= GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_Y)*GAMEPAD_LOOK_SPEED*dt;
 
-void BeanPitch(LocalBean* bean, float angle, bool lockView, bool rotateAroundTarget, bool rotateUp)
-{
-    // Up direction
-    Vector3 up = GetBeanUp(bean);
-
-    // View vector
-    Vector3 targetPosition = Vector3Subtract(bean->target, bean->transform.translation);
-
-    if (lockView)
-    {
-        // In these camera modes we clamp the Pitch angle
-        // to allow only viewing straight up or down.
-
-        // Clamp view up
-        float maxAngleUp = Vector3Angle(up, targetPosition);
-        maxAngleUp -= 0.001f; // avoid numerical errors
-        if (angle > maxAngleUp) angle = maxAngleUp;
-
-        // Clamp view down
-        float maxAngleDown = Vector3Angle(Vector3Negate(up), targetPosition);
-        maxAngleDown *= -1.0f; // downwards angle is negative
-        maxAngleDown += 0.001f; // avoid numerical errors
-        if (angle < maxAngleDown) angle = maxAngleDown;
+        Vector2 stick = { GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X), -GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_Y) };
+        if (Vector2Length(stick) > GAMEPAD_DEADZONE) move = Vector2Add(move, stick);
     }
 
-    // Rotation axis
-    Vector3 right = GetBeanRight(bean);
-
-    // Rotate view vector around right axis
-    targetPosition = Vector3RotateByAxisAngle(targetPosition, right, angle);
-    
-    bean->target = Vector3Add(bean->transform.translation, targetPosition);
-
-    if (rotateUp)
-    {
-        // Rotate up direction around right axis
-        bean->up = Vector3RotateByAxisAngle(bean->up, right, angle);
-    }
-    UpdateCameraWithBean(bean);
+    // diagonals aren't faster
+    if (Vector2Length(move) > 1.0f) move = Vector2Normalize(move);
+    intent->move = Vector2Add(intent->move, move);
+    if (Vector2Length(intent->move) > 1.0f) intent->move = Vector2Normalize(intent->move);
 }
 
-#define BEAN_MOVE_SPEED 0.09f
-#define CAMERA_MOUSE_SPEED 0.003f
-#define CAMERA_ROTATION 0.03f
-
-void UpdateLocalBean(LocalBean* bean) {
-    Vector2 mousePositionDelta = GetMouseDelta();
-
-    bool moveInWorldPlane = ((bean->cameraMode == CAMERA_FIRST_PERSON) || (bean->cameraMode == CAMERA_THIRD_PERSON));
-    bool rotateAroundTarget = ((bean->cameraMode == CAMERA_THIRD_PERSON) || (bean->cameraMode == CAMERA_ORBITAL));
-    bool lockView = ((bean->cameraMode == CAMERA_FREE) || (bean->cameraMode == CAMERA_FIRST_PERSON) || (bean->cameraMode == CAMERA_THIRD_PERSON) || (bean->cameraMode == CAMERA_ORBITAL));
-    bool rotateUp = false;
-
-    bean->posAdd = Vector3Zero();
-
-    if(IsKeyDown(KEY_DOWN)) BeanPitch(bean, -CAMERA_ROTATION, lockView, rotateAroundTarget, rotateUp);
-    if(IsKeyDown(KEY_UP)) BeanPitch(bean, CAMERA_ROTATION, lockView, rotateAroundTarget, rotateUp);
-    if(IsKeyDown(KEY_RIGHT)) BeanYaw(bean, -CAMERA_ROTATION, rotateAroundTarget);
-    if(IsKeyDown(KEY_LEFT)) BeanYaw(bean, -CAMERA_ROTATION, rotateAroundTarget);
+void UpdateLocalBean(LocalBean* bean, const BeanIntent* intent, const CollisionWorld* world, float dt) {
+    bean->lastTranslation = bean->transform.translation;
 
-    BeanYaw(bean, -mousePositionDelta.x*CAMERA_MOUSE_SPEED, rotateAroundTarget);
-    BeanPitch(bean, -mousePositionDelta.y*CAMERA_MOUSE_SPEED, lockView, rotateAroundTarget, rotateUp);
+    // turning is one composition per tick no matter how many inputs went into it
+    if (intent->yaw != 0.0f || intent->pitch != 0.0f) {
+        bean->yaw = fmodf(bean->yaw + intent->yaw, 2.0f*PI);
+        bean->pitch = Clamp(bean->pitch + intent->pitch, -BEAN_PITCH_LIMIT, BEAN_PITCH_LIMIT);
+        UpdateBeanRotation(bean);
+    }
 
-    if (IsKeyDown(KEY_W)) BeanMoveForward(bean, BEAN_MOVE_SPEED, moveInWorldPlane);
-    if (IsKeyDown(KEY_A)) BeanMoveRight(bean, -BEAN_MOVE_SPEED, moveInWorldPlane);
-    if (IsKeyDown(KEY_S)) BeanMoveForward(bean, -BEAN_MOVE_SPEED, moveInWorldPlane);
-    if (IsKeyDown(KEY_D)) BeanMoveRight(bean, BEAN_MOVE_SPEED, moveInWorldPlane);
+    // walking only follows yaw, looking down doesn't slow you down
+    Vector3 forward = { -sinf(bean->yaw), 0.0f, -cosf(bean->yaw) };
+    Vector3 right = { cosf(bean->yaw), 0.0f, -sinf(bean->yaw) };
+    Vector3 walk = Vector3Scale(Vector3Add(Vector3Scale(forward, intent->move.y), Vector3Scale(right, intent->move.x)), BEAN_MOVE_SPEED*dt);
+
+    // the intent only says where the bean wants to go, the controller slides it along the level and lets it fall
+    Vector3 start = bean->transform.translation;
+    Vector3 end = MoveBean(world, &bean->body, start, walk, dt);
+    bean->posAdd = Vector3Subtract(end, start);
+    if (bean->posAdd.x != 0.0f || bean->posAdd.y != 0.0f || bean->posAdd.z != 0.0f) {
+        bean->transform.translation = end;
+        bean->cameraDirty = true;
+    }
 
-    if (IsGamepadAvailable(0)) {
-        // Gamepad controller support
-        BeanYaw(bean, -(GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_X) * 2)*CAMERA_MOUSE_SPEED, rotateAroundTarget);
-        BeanPitch(bean, -(GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_Y) * 2)*CAMERA_MOUSE_SPEED, lockView, rotateAroundTarget, rotateUp);
-        
-        if (GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_Y) <= -0.25f) BeanMoveForward(bean, BEAN_MOVE_SPEED, moveInWorldPlane);
-        if (GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X) <= -0.25f) BeanMoveRight(bean, -BEAN_MOVE_SPEED, moveInWorldPlane);
-        if (GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_Y) >= 0.25f) BeanMoveForward(bean, -BEAN_MOVE_SPEED, moveInWorldPlane);
-        if (GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X) >= 0.25f) BeanMoveRight(bean, BEAN_MOVE_SPEED, moveInWorldPlane);
+    if (bean->transform.translation.y < BEAN_KILL_HEIGHT) {
+        Vector3 spawn;
+        SpawnTheBigBean(GetLocalPlayerId(), &spawn);
+        // don't land on the spawn point at the speed we were falling off the map at
+        bean->body = (BeanBody){ 0 };
+        bean->lastTranslation = spawn;
     }
 
     bean->beanCollide = (BoundingBox){
-        (Vector3){bean->transform.translation.x - 0.7f, bean->transform.translation.y - 1.7f, bean->transform.translation.z - 0.7f},
-        (Vector3){bean->transform.translation.x + 0.7f, bean->transform.translation.y + 0.9f, bean->transform.translation.z + 0.7f}};
+        (Vector3){bean->transform.translation.x - BEAN_CAPSULE_RADIUS, bean->transform.translation.y + BEAN_CAPSULE_BOTTOM - BEAN_CAPSULE_RADIUS, bean->transform.translation.z - BEAN_CAPSULE_RADIUS},
+        (Vector3){bean->transform.translation.x + BEAN_CAPSULE_RADIUS, bean->transform.translation.y + BEAN_CAPSULE_TOP + BEAN_CAPSULE_RADIUS, bean->transform.translation.z + BEAN_CAPSULE_RADIUS}};
 
     HandleCollision();
 
-    bean->topCap = (Vector3){bean->transform.translation.x, bean->transform.translation.y + 0.2f, bean->transform.translation.z};
-    bean->botCap = (Vector3){bean->transform.translation.x, bean->transform.translation.y - 1.0f, bean->transform.translation.z};
+    bean->topCap = (Vector3){bean->transform.translation.x, bean->transform.translation.y + BEAN_CAPSULE_TOP, bean->transform.translation.z};
+    bean->botCap = (Vector3){bean->transform.translation.x, bean->transform.translation.y + BEAN_CAPSULE_BOTTOM, bean->transform.translation.z};
 
     // update the local player in the player list
-    UpdatePlayerList(bean->transform.translation, bean->beanColor.r, bean->beanColor.g, bean->beanColor.b, bean->beanColor.a);
+    UpdatePlayerList(bean->transform.translation, Vector3Scale(Vector3Subtract(bean->transform.translation, bean->lastTranslation), 1.0f/dt));
+    UpdatePlayerAttributes(bean->beanColor.r, bean->beanColor.g, bean->beanColor.b, bean->beanColor.a);
+}
+
+Vector3 GetBeanDrawPosition(LocalBean* bean, float alpha) {
+    return Vector3Lerp(bean->lastTranslation, bean->transform.translation, alpha);
+}
+
+Camera GetBeanDrawCamera(LocalBean* bean, float alpha) {
+    // the whole camera slides back by however far the drawn position is behind the latest tick
+    Vector3 offset = Vector3Subtract(GetBeanDrawPosition(bean, alpha), bean->transform.translation);
+    Camera camera = GetBeanCamera(bean);
+    camera.position = Vector3Add(camera.position, offset);
+    camera.target = Vector3Add(camera.target, offset);
+    return camera;
 }
@@ -27,21 +27,38 @@
 **********************************************************************************************/
 
 // server code
+// build with: cc -O2 -Iinclude -DRAYMATH_STATIC_INLINE server.c net_common.c collision.c level.c -lm -o server
+// and run it next to a level file (tools/Makefile writes them into meta_quest/Sources/assets), or pass one as the first argument
 
 #define ENET_IMPLEMENTATION
 #include "net/net_common.h"
+#include "level.h"
+#include "collision.h"
+#include "raylib/raymath.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// how many snapshots to one player can be waiting on an ack at once, past that they count as backed up
+#define SNAPSHOT_HISTORY 64
+
+// a snapshot that went out, and which changes about each other player were in it. it stays in flight until enet
+// frees the packet after the ack, if the connection drops first whatever is still in flight goes again on resume
+typedef struct
+{
+	bool InFlight;
+	uint8_t Sent[MAX_PLAYERS];
+}SentSnapshot;
+
 // the info we are tracking about each player in the game
 typedef struct
 {
 	// is this player slot active
 	bool Active;
 
-	// have they sent us a valid position yet?
+	// do they have a position yet, they get one (a spawn point) as soon as they join
 	bool ValidPosition;
 
 	// the network connection they use
@@ -52,18 +69,95 @@ typedef struct
 	float Y;
     float Z;
 
+	// how fast they said they're going, passed on so everyone can carry them along between updates
+	Vector3 Velocity;
+
     uint8_t R;
     uint8_t G;
     uint8_t B;
     uint8_t A;
+
+	// their respawn count from the last UpdateInput, when it changes they get to jump to a spawn point
+	uint8_t RespawnCount;
+	// how many times we've put them back where our sweep ended, updates sent before they heard about the last one are stale
+	uint8_t CorrectionCount;
+
+	// have they told us their attributes yet, and which revision of them we have
+	bool HasAttributes;
+	uint16_t AttributesRevision;
+
+	// head and hands, kept whole so late joiners get all of it even though updates only carry what changed
+	PlayerPose Pose;
+
+	// how fast we can send to them, and when their next snapshot goes out
+	LinkRate Link;
+	double NextSnapshot;
+	// how many snapshots they've had, what the distance tiers count in
+	uint32_t SnapshotCount;
+
+	// what this one hasn't heard yet about each other player, pose parts and the PENDING_ flags. only what changed is kept,
+	// the message itself gets written from the newest state when their snapshot goes out, so a slow link never falls behind
+	// on old positions, it just skips them
+	uint8_t Pending[MAX_PLAYERS];
+
+	// how much each other player's pending changes matter to this one, grows while they wait and goes back to 0 once sent
+	float Priority[MAX_PLAYERS];
+
+	// the last SNAPSHOT_HISTORY snapshots they were sent, SnapshotCount picks the slot the next one goes in
+	SentSnapshot Sent[SNAPSHOT_HISTORY];
+
+	// what they connect with to get this slot back after a drop. while Peer is NULL the slot is held for them until ResumeUntil
+	uint32_t ResumeToken;
+	double ResumeUntil;
 }PlayerInfo;
 
+// in Pending, the low bits are the POSE_ parts. then the position and velocity changed, they need an AddPlayer,
+// their attributes changed, or they left (that one goes first, the slot can have someone new in it already)
+#define PENDING_MOVED 0x10
+#define PENDING_ADDED 0x20
+#define PENDING_ATTRIBUTES 0x40
+#define PENDING_REMOVED 0x80
+
+// snapshots go out to each player somewhere between these rates, depending on how much their link takes
+#define SNAPSHOT_MIN_RATE 10
+#define SNAPSHOT_MAX_RATE 60
+// command, id, position, velocity and a whole pose
+#define SNAPSHOT_ENTRY_MAX_SIZE (20 + POSE_MAX_SIZE)
+// the most one Pending slot can turn into, a remove, the attributes and an add
+#define PENDING_ENTRY_MAX_SIZE (2 + 8 + SNAPSHOT_ENTRY_MAX_SIZE)
+// the biggest a snapshot can be, they're kept to one unfragmented packet of the peer's mtu
+#define SNAPSHOT_MAX_SIZE ENET_PROTOCOL_MAXIMUM_MTU
+
+// priority per second a waiting player gathers: 1 right next to you, halved at this distance
+#define PRIORITY_DISTANCE 10.0f
+// and scaled down to this when they're straight behind your head, all the way up when you're looking at them
+#define PRIORITY_BEHIND 0.25f
+
+// the farther away someone is the fewer of your snapshots they're in: all of them within the first distance,
+// every other one within the second, every fourth past that. you can't see the difference that far away
+#define TIER_FULL_DISTANCE 5.0f
+#define TIER_HALF_DISTANCE 20.0f
+// how long to sit in enet_host_service when nobody needs a snapshot
+#define SERVER_IDLE_WAIT 1000
+
+// how close to a spawn point a respawn has to land to count
+#define SPAWN_TOLERANCE 0.01f
+// how far our sweep can end up from where the client says it went before we tell them where they really are
+#define CORRECTION_TOLERANCE 0.01f
+
+// how long a dropped player's slot and bean stay around for them to reconnect to, in seconds
+#define RESUME_GRACE 15.0
+
 
 // The list of all possible players
 // this is the server state of the game that represents the current game state
 // this is what server code would check to see where all the players are and what they are doing
 PlayerInfo Players[MAX_PLAYERS] = { 0 };
 
+// the same level and collision the clients use, so moves can be checked against the world
+Level level = { 0 };
+CollisionWorld collisionWorld = { 0 };
+
 // finds the player slot that goes with the player connection
 // the peer has the void* ENetPeer::data that can be used to store arbitary application data
 // but that involves managing structure pointers so it is kept out of this example
@@ -78,25 +172,440 @@ int GetPlayerId(ENetPeer* peer)
 	return -1;
 }
 
-// sends a packet over the network to every active player, except the one specified (usually the sender)
+// tells every active player, except the one it's about, that something changed about a player. nothing is sent here,
+// it goes out with each of their next snapshots from whatever the state is by then
 // senders know what they sent so you can choose to not send them data they already know.
 // in a truly authoritative server you'd send back an acceptance message to all client input so they know it wasn't rejected.
-void SendToAllBut(ENetPacket* packet, int exceptPlayerId)
+void MarkPending(int playerId, uint8_t pending)
+{
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (!Players[i].Active || i == playerId)
+			continue;
+
+		Players[i].Pending[playerId] |= pending;
+	}
+}
+
+// an AddPlayer or UpdatePlayer for a player, with the pose parts asked for. returns the size, SNAPSHOT_ENTRY_MAX_SIZE at most
+size_t WritePlayerState(uint8_t* buffer, NetworkCommands command, int playerId, uint8_t poseParts)
+{
+	buffer[0] = (uint8_t)command;
+	buffer[1] = (uint8_t)playerId;
+	*(float*)(buffer + 2) = (float)Players[playerId].X;
+	*(float*)(buffer + 6) = (float)Players[playerId].Y;
+	*(float*)(buffer + 10) = (float)Players[playerId].Z;
+	WriteVelocity(buffer + 14, Players[playerId].Velocity);
+	return 20 + WritePose(buffer + 20, &Players[playerId].Pose, poseParts);
+}
+
+// a PlayerAttributes message with everything we know about a player's static info, 8 bytes
+size_t WritePlayerAttributes(uint8_t* buffer, int playerId)
+{
+	buffer[0] = (uint8_t)PlayerAttributes;
+	buffer[1] = (uint8_t)playerId;
+	*(uint16_t*)(buffer + 2) = Players[playerId].AttributesRevision;
+	buffer[4] = Players[playerId].R;
+	buffer[5] = Players[playerId].G;
+	buffer[6] = Players[playerId].B;
+	buffer[7] = Players[playerId].A;
+	return 8;
+}
+
+// the messages a Pending slot stands for, written from the player's state as it is now. returns the size, PENDING_ENTRY_MAX_SIZE at most
+size_t WritePending(uint8_t* buffer, int playerId, uint8_t pending)
+{
+	size_t size = 0;
+	if (pending & PENDING_REMOVED)
+	{
+		buffer[size++] = (uint8_t)RemovePlayer;
+		buffer[size++] = (uint8_t)playerId;
+	}
+
+	if (!Players[playerId].Active)
+		return size;
+
+	if ((pending & PENDING_ATTRIBUTES) && Players[playerId].HasAttributes)
+		size += WritePlayerAttributes(buffer + size, playerId);
+
+	// an add has all of it, so whatever moved since doesn't need an update as well
+	if (!Players[playerId].ValidPosition)
+		return size;
+	if (pending & PENDING_ADDED)
+		size += WritePlayerState(buffer + size, AddPlayer, playerId, POSE_ALL);
+	else if (pending & (PENDING_MOVED | POSE_ALL))
+		size += WritePlayerState(buffer + size, UpdatePlayer, playerId, pending & POSE_ALL);
+	return size;
+}
+
+// has enet still not put everything we gave it for this player on the wire, is more than a window of it unacknowledged,
+// or are we out of room to remember snapshots in. then anything new would just queue up behind it, better to leave it
+// in Pending where newer state can replace it
+bool IsBackedUp(const PlayerInfo* player)
+{
+	ENetPeer* peer = player->Peer;
+	return !enet_list_empty(&peer->outgoingReliableCommands) || peer->reliableDataInTransit > peer->windowSize ||
+		player->Sent[player->SnapshotCount % SNAPSHOT_HISTORY].InFlight;
+}
+
+// enet is done with a snapshot packet. it only gets the SENT flag when the ack came back, a packet thrown away
+// because the connection was reset never arrived and stays in flight
+void SnapshotFreed(void* data)
+{
+	ENetPacket* packet = (ENetPacket*)data;
+	if (packet->flags & ENET_PACKET_FLAG_SENT)
+		((SentSnapshot*)packet->userData)->InFlight = false;
+}
+
+// when priorities were last added to
+double LastPriorityUpdate = 0;
+
+// how much a change to the player at target matters to observer, per second it waits
+float GetPriority(const PlayerInfo* observer, const PlayerInfo* target)
+{
+	Vector3 offset = { target->X - observer->X, target->Y - observer->Y, target->Z - observer->Z };
+	float distance = Vector3Length(offset);
+	float priority = 1.0f / (1.0f + distance / PRIORITY_DISTANCE);
+
+	// the head looks from the bean's own frame, see net_pose.h
+	if (distance > 0.0f)
+	{
+		Vector3 forward = Vector3RotateByQuaternion((Vector3){ 0.0f, 0.0f, -1.0f }, QuaternionMultiply(observer->Pose.rotation, observer->Pose.head));
+		float facing = Vector3DotProduct(forward, offset) / distance;
+		priority *= PRIORITY_BEHIND + (1.0f - PRIORITY_BEHIND) * (facing > 0.0f ? facing : 0.0f);
+	}
+	return priority;
+}
+
+// is the player at targetId due in observer's snapshot this time, going by how far apart they are.
+// everyone's turns are spread out by id so the snapshots stay about the same size instead of bunching up
+bool IsTierDue(const PlayerInfo* observer, int observerId, int targetId)
+{
+	// joining, leaving and attributes aren't something you can half see, they always go
+	if (observer->Pending[targetId] & (PENDING_ADDED | PENDING_ATTRIBUTES | PENDING_REMOVED))
+		return true;
+
+	const PlayerInfo* target = &Players[targetId];
+	float distance = Vector3Distance((Vector3){ observer->X, observer->Y, observer->Z }, (Vector3){ target->X, target->Y, target->Z });
+	uint32_t every = distance < TIER_FULL_DISTANCE ? 1 : distance < TIER_HALF_DISTANCE ? 2 : 4;
+	return (observer->SnapshotCount + (uint32_t)(observerId + targetId)) % every == 0;
+}
+
+// the most an unfragmented packet to this peer can carry
+size_t GetSnapshotFit(ENetPeer* peer)
+{
+	size_t fit = peer->mtu - sizeof(ENetProtocolHeader) - sizeof(ENetProtocolSendFragment);
+	if (peer->host->checksum != NULL)
+		fit -= sizeof(enet_uint32);
+	return fit < SNAPSHOT_MAX_SIZE ? fit : SNAPSHOT_MAX_SIZE;
+}
+
+// everything that changed since each player's last snapshot, packed back to back into one packet,
+// for every player whose link says it's time. the ones that matter most to them go first,
+// and whatever doesn't fit their budget waits (and keeps gaining priority) for the next one
+void SendSnapshots(ENetHost* host, double now)
+{
+	float elapsed = LastPriorityUpdate > 0 ? (float)(now - LastPriorityUpdate) : 0.0f;
+	LastPriorityUpdate = now;
+
+	int others = -1;
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (Players[i].ValidPosition)
+			others++;
+	}
+
+	uint32_t total = 0;
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		PlayerInfo* observer = &Players[i];
+		if (!observer->Active || observer->Peer == NULL)
+			continue;
+
+		UpdateLinkRate(&observer->Link, observer->Peer, now, SNAPSHOT_MIN_RATE, SNAPSHOT_MAX_RATE, (others > 0 ? others : 1) * SNAPSHOT_ENTRY_MAX_SIZE);
+		total += observer->Link.bandwidth;
+
+		// only changes that haven't gone out yet gather priority, so the longer one waits the sooner it goes
+		int waiting[MAX_PLAYERS];
+		int waitingCount = 0;
+		for (int j = 0; j < MAX_PLAYERS; j++)
+		{
+			if (j == i || !observer->Pending[j])
+			{
+				observer->Priority[j] = 0.0f;
+				continue;
+			}
+
+			observer->Priority[j] += elapsed * GetPriority(observer, &Players[j]);
+			waiting[waitingCount++] = j;
+		}
+
+		if (now < observer->NextSnapshot)
+			continue;
+		observer->NextSnapshot = now + observer->Link.interval;
+		if (IsBackedUp(observer))
+			continue;
+		SentSnapshot* sent = &observer->Sent[observer->SnapshotCount % SNAPSHOT_HISTORY];
+		memset(sent->Sent, 0, sizeof(sent->Sent));
+		observer->SnapshotCount++;
+
+		// highest priority first, there's only ever a handful
+		for (int a = 1; a < waitingCount; a++)
+		{
+			int j = waiting[a];
+			int b = a;
+			for (; b > 0 && observer->Priority[waiting[b - 1]] < observer->Priority[j]; b--)
+				waiting[b] = waiting[b - 1];
+			waiting[b] = j;
+		}
+
+		size_t fit = GetSnapshotFit(observer->Peer);
+		// the first one after joining is the whole world, it gets a full packet whatever the link has found so far
+		size_t budget = observer->Link.budget < fit && observer->SnapshotCount > 1 ? observer->Link.budget : fit;
+		uint8_t buffer[SNAPSHOT_MAX_SIZE];
+		size_t size = 0;
+		for (int a = 0; a < waitingCount; a++)
+		{
+			int j = waiting[a];
+			if (!IsTierDue(observer, i, j))
+				continue;
+
+			uint8_t entry[PENDING_ENTRY_MAX_SIZE];
+			size_t entrySize = WritePending(entry, j, observer->Pending[j]);
+
+			// a smaller one further down might still fit. always at least one, or a tiny budget would never send anything
+			if (size > 0 && size + entrySize > budget)
+				continue;
+
+			memcpy(buffer + size, entry, entrySize);
+			size += entrySize;
+			sent->Sent[j] = observer->Pending[j];
+			observer->Pending[j] = 0;
+			observer->Priority[j] = 0.0f;
+		}
+
+		if (size > 0)
+		{
+			ENetPacket* packet = enet_packet_create(buffer, size, ENET_PACKET_FLAG_RELIABLE);
+			packet->userData = sent;
+			packet->freeCallback = SnapshotFreed;
+			sent->InFlight = true;
+			enet_peer_send(observer->Peer, 0, packet);
+		}
+	}
+
+	// let enet's own throttle work from the same numbers, it tells the clients when this changes
+	if (total != host->outgoingBandwidth)
+		enet_host_bandwidth_limit(host, 0, total);
+}
+
+// how long until the next snapshot is due or a held slot runs out, in ms
+enet_uint32 GetWaitTime(double now)
+{
+	double next = now + SERVER_IDLE_WAIT / 1000.0;
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (!Players[i].Active)
+			continue;
+
+		double due = Players[i].Peer != NULL ? Players[i].NextSnapshot : Players[i].ResumeUntil;
+		if (due < next)
+			next = due;
+	}
+	return next > now ? (enet_uint32)((next - now) * 1000.0) : 0;
+}
+
+// where resume tokens come from, opened at startup. without it nobody gets a token and resuming is off
+FILE* RandomSource = NULL;
+
+// a token to resume a slot with, RESUME_TOKEN_MASK bits and never 0 (that's connecting without one).
+// straight from the os, anything seeded would let a player work out everyone else's from their own
+uint32_t NewResumeToken()
+{
+	if (RandomSource == NULL)
+		return 0;
+
+	uint32_t token = 0;
+	while (token == 0)
+	{
+		if (fread(&token, sizeof(token), 1, RandomSource) != 1)
+			return 0;
+		token &= RESUME_TOKEN_MASK;
+	}
+	return token;
+}
+
+// the slot is free again, everyone gets told they left
+void ReleasePlayer(int playerId)
+{
+	// mark them as inactive and clear the peer pointer
+	Players[playerId].Active = false;
+	Players[playerId].ValidPosition = false;
+	Players[playerId].Peer = NULL;
+	Players[playerId].ResumeToken = 0;
+
+	// Tell everyone that someone left, whatever else they hadn't heard about them doesn't matter anymore
+	for (int i = 0; i < MAX_PLAYERS; i++)
+		Players[i].Pending[playerId] = PENDING_REMOVED;
+}
+
+// let go of the slots nobody came back for
+void ReleaseHeldPlayers(double now)
+{
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (Players[i].Active && Players[i].Peer == NULL && now >= Players[i].ResumeUntil)
+		{
+			printf("Player %d didn't come back\n", i);
+			ReleasePlayer(i);
+		}
+	}
+}
+
+// a dropped player connected again with their token, give them their slot back. false if there's nothing to resume
+bool ResumePlayer(ENetPeer* peer, uint32_t token, int* playerId)
 {
+	if (token == 0)
+		return false;
+
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
-		if (!Players[i].Active || i == exceptPlayerId)
+		if (!Players[i].Active || Players[i].ResumeToken != token)
 			continue;
 
-		enet_peer_send(Players[i].Peer, 0, packet);
+		// their side can notice the drop and come back before ours times out, then the old connection is dead.
+		// but only take it over from the same address, a live player somewhere else doesn't get kicked for a token
+		if (Players[i].Peer != NULL)
+		{
+			if (memcmp(&Players[i].Peer->address.host, &peer->address.host, sizeof(peer->address.host)) != 0)
+				return false;
+			enet_peer_reset(Players[i].Peer);
+		}
+		Players[i].Peer = peer;
+
+		// everything that changed while they were gone is in Pending already, and the snapshots that were never acked
+		// might not have made it, so what was in those goes again. they still have the rest
+		for (int s = 0; s < SNAPSHOT_HISTORY; s++)
+		{
+			SentSnapshot* sent = &Players[i].Sent[s];
+			if (!sent->InFlight)
+				continue;
+
+			for (int j = 0; j < MAX_PLAYERS; j++)
+				Players[i].Pending[j] |= sent->Sent[j];
+			sent->InFlight = false;
+		}
+		*playerId = i;
+		return true;
+	}
+	return false;
+}
+
+// is position one of the level's spawn points (or the old spot on the field when there aren't any), where respawns can jump to
+bool IsSpawnPoint(Vector3 position)
+{
+	if (level.spawnCount == 0)
+		return Vector3Distance(position, (Vector3){ 0.0f, 1.7f, 4.0f }) < SPAWN_TOLERANCE;
+
+	for (uint32_t i = 0; i < level.spawnCount; i++)
+	{
+		if (Vector3Distance(position, level.spawns[i].position) < SPAWN_TOLERANCE)
+			return true;
 	}
+	return false;
+}
+
+// tell a player where they really are, after their last move didn't end up there for us
+void SendCorrection(int playerId)
+{
+	uint8_t buffer[14];
+	buffer[0] = (uint8_t)CorrectPosition;
+	buffer[1] = Players[playerId].CorrectionCount;
+	*(float*)(buffer + 2) = Players[playerId].X;
+	*(float*)(buffer + 6) = Players[playerId].Y;
+	*(float*)(buffer + 10) = Players[playerId].Z;
+	enet_peer_send(Players[playerId].Peer, 0, enet_packet_create(buffer, sizeof(buffer), ENET_PACKET_FLAG_RELIABLE));
+}
+
+// a new player in an empty slot, with what they connected with. they get put at a spawn point right away and everyone
+// hears about them in their next snapshot, no waiting for a first update. returns the yaw they spawn facing
+float JoinPlayer(int playerId, ENetPeer* peer, const JoinRequest* join)
+{
+	// player is good, don't give away the slot
+	Players[playerId].Active = true;
+	Players[playerId].ResumeToken = NewResumeToken();
+	Players[playerId].Peer = peer;
+	Players[playerId].SnapshotCount = 0;
+	ResetPose(&Players[playerId].Pose);
+
+	// the color they connected with is a little rounded, the exact one follows in PlayerAttributes with a newer revision
+	Players[playerId].R = join->color.r;
+	Players[playerId].G = join->color.g;
+	Players[playerId].B = join->color.b;
+	Players[playerId].A = join->color.a;
+	Players[playerId].HasAttributes = true;
+	Players[playerId].AttributesRevision = 0;
+
+	// the spawn point they asked for, or the level's spawn points in turn like the clients used to pick, or the old spot on the field
+	Vector3 position = { 0.0f, 1.7f, 4.0f };
+	float yaw = 0.0f;
+	if (level.spawnCount > 0)
+	{
+		const LevelSpawn* spawn = &level.spawns[join->spawn >= 0 && (uint32_t)join->spawn < level.spawnCount ? (uint32_t)join->spawn : playerId % level.spawnCount];
+		position = spawn->position;
+		yaw = spawn->yaw;
+	}
+	Players[playerId].X = position.x;
+	Players[playerId].Y = position.y;
+	Players[playerId].Z = position.z;
+	Players[playerId].Velocity = (Vector3){ 0 };
+	Players[playerId].ValidPosition = true;
+	Players[playerId].RespawnCount = 0;
+	Players[playerId].CorrectionCount = 0;
+
+	// whoever had the slot before left, everyone else gets that first
+	for (int i = 0; i < MAX_PLAYERS; i++)
+		Players[i].Pending[playerId] &= PENDING_REMOVED;
+	MarkPending(playerId, PENDING_ADDED | PENDING_ATTRIBUTES);
+
+	// We have to tell the new client about all the other players that are already on the server
+	// so their first snapshots have the attributes and an add for all existing active players
+	memset(Players[playerId].Pending, 0, sizeof(Players[playerId].Pending));
+	memset(Players[playerId].Sent, 0, sizeof(Players[playerId].Sent));
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (i == playerId || !Players[i].Active)
+			continue;
+
+		if (Players[i].HasAttributes)
+			Players[playerId].Pending[i] |= PENDING_ATTRIBUTES;
+		if (Players[i].ValidPosition)
+			Players[playerId].Pending[i] |= PENDING_ADDED;
+	}
+	return yaw;
 }
 
 // the main server loop
-int main()
+int main(int argc, char* argv[])
 {
 	printf("Startup\n");
 
+	const char* levelPath = argc > 1 ? argv[1] : "arena.level";
+	if (LoadLevel(&level, levelPath))
+	{
+		CollisionWorldFromLevel(&collisionWorld, &level);
+		printf("Loaded %s\n", levelPath);
+	}
+	else
+	{
+		// without a level nothing gets checked, positions are taken as they come
+		printf("Couldn't load %s, running without collision\n", levelPath);
+	}
+
+	RandomSource = fopen("/dev/urandom", "rb");
+	if (RandomSource == NULL)
+		printf("Couldn't open /dev/urandom, dropped players can't resume\n");
+
 	// set up networking
 	if (enet_initialize() != 0)
 		return 1;
@@ -124,10 +633,10 @@ int main()
 	while (run)
 	{
 		ENetEvent event = { 0 };
+		double now = enet_time_get() / 1000.0;
 
-		// see if there are any inbound network events, wait up to 1000ms before returning.
-		// if the server also did game logic, this timeout should be lowered
-		if (enet_host_service(server, &event, 1000) > 0)
+		// see if there are any inbound network events, waiting until the next snapshot is due at most
+		if (enet_host_service(server, &event, GetWaitTime(now)) > 0)
 		{
 			// see what kind of event we have
 			switch (event.type)
@@ -138,9 +647,30 @@ int main()
 				{
 					printf("Player Connected\n");
 
-					// find an empty slot, or disconnect them if we are full
+					// the connect data says who they are (see JoinRequest), anything not speaking our protocol gets turned away
+					JoinRequest join;
+					UnpackJoinRequest(event.data, &join);
+					if (join.version != PROTOCOL_VERSION)
+					{
+						printf("Wrong protocol version %d\n", join.version);
+						enet_peer_disconnect(event.peer, DISCONNECT_VERSION);
+						break;
+					}
+
+					// the token from their last AcceptPlayer if they dropped gets them straight back in
 					int playerId = 0;
-					for (; playerId < MAX_PLAYERS; playerId++)
+					bool resumed = ResumePlayer(event.peer, join.resumeToken, &playerId);
+
+					// a resume only has the token, no color or spawn point. if the slot is gone, send them back to join properly
+					if (join.resumeToken != 0 && !resumed)
+					{
+						printf("Nothing to resume\n");
+						enet_peer_disconnect(event.peer, DISCONNECT_STALE_RESUME);
+						break;
+					}
+
+					// otherwise they're new, find an empty slot, or disconnect them if we are full. held slots aren't empty
+					for (; !resumed && playerId < MAX_PLAYERS; playerId++)
 					{
 						if (!Players[playerId].Active)
 							break;
@@ -154,52 +684,36 @@ int main()
 						break;
 					}
 
-					// player is good, don't give away the slot
-					Players[playerId].Active = true;
+					float yaw = 0.0f;
+					if (resumed)
+						printf("Player %d resumed\n", playerId);
+					else
+						yaw = JoinPlayer(playerId, event.peer, &join);
 
-					// but don't send out an update to everyone until they give us a good position
-					Players[playerId].ValidPosition = false;
-					Players[playerId].Peer = event.peer;
+					// start their link somewhere reasonable and let it find its level, enet's throttle reacts about as fast as ours does
+					InitLinkRate(&Players[playerId].Link, now, SNAPSHOT_MAX_RATE);
+					Players[playerId].NextSnapshot = now;
+					enet_peer_throttle_configure(event.peer, LINK_THROTTLE_INTERVAL, ENET_PEER_PACKET_THROTTLE_ACCELERATION, ENET_PEER_PACKET_THROTTLE_DECELERATION * 2);
 
 					// pack up a message to send back to the client to tell them they have been accepted as a player
-					uint8_t buffer[2] = { 0 };
+					uint8_t buffer[23] = { 0 };
 					buffer[0] = (uint8_t)AcceptPlayer;  // command for the client
 					buffer[1] = (uint8_t)playerId;      // the player ID so they know who they are
+					*(uint32_t*)(buffer + 2) = Players[playerId].ResumeToken;
+					buffer[6] = resumed;
+					*(float*)(buffer + 7) = Players[playerId].X;   // and where they are
+					*(float*)(buffer + 11) = Players[playerId].Y;
+					*(float*)(buffer + 15) = Players[playerId].Z;
+					*(float*)(buffer + 19) = yaw;
 
 					// copy the buffer into an enet packet (TODO : add write functions to go directly to a packet)
-					ENetPacket* packet = enet_packet_create(buffer, 2, ENET_PACKET_FLAG_RELIABLE);
-					// send the data to the user
+					ENetPacket* packet = enet_packet_create(buffer, 23, ENET_PACKET_FLAG_RELIABLE);
+					// send the data to the user. their first snapshot, with the whole world in it, goes out right behind this
+					// in the same service, so both get there in one round trip from their connect
 					enet_peer_send(event.peer, 0, packet);
 
-					// We have to tell the new client about all the other players that are already on the server
-					// so send them an add message for all existing active players.
-					for (int i = 0; i < MAX_PLAYERS; i++)
-					{
-						// only people who are valid and not the new player
-						if (i == playerId || !Players[i].ValidPosition)
-							continue;
-
-						// pack up an add player message with the ID and the last known position
-						uint8_t addBuffer[18] = { 0 };
-						addBuffer[0] = (uint8_t)AddPlayer;
-						addBuffer[1] = (uint8_t)i;
-						*(float*)(addBuffer + 2) = (float)Players[i].X;
-						*(float*)(addBuffer + 6) = (float)Players[i].Y;
-						*(float*)(addBuffer + 10) = (float)Players[i].Z;
-                        *(uint8_t*)(addBuffer + 14) = (uint8_t)Players[i].R;
-                        *(uint8_t*)(addBuffer + 15) = (uint8_t)Players[i].G;
-                        *(uint8_t*)(addBuffer + 16) = (uint8_t)Players[i].B;
-						*(uint8_t*)(addBuffer + 17) = (uint8_t)Players[i].A;
-
-						// Optimally we'd also send other info like name, color, and other static player info.
-
-						// copy and send the message
-						packet = enet_packet_create(addBuffer, 18, ENET_PACKET_FLAG_RELIABLE);
-						enet_peer_send(event.peer, 0, packet);
-
-						// NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-						// you don't have to destroy them
-					}
+					// NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
+					// you don't have to destroy them
 					break;
 				}
 
@@ -229,43 +743,66 @@ int main()
 					if (command == UpdateInput)
 					{
 						// update the location data with the new info
-						Players[playerId].X = ReadFloat(event.packet, &offset);
-						Players[playerId].Y = ReadFloat(event.packet, &offset);
-						Players[playerId].Z = ReadFloat(event.packet, &offset);
+						Vector3 position = { 0 };
+						position.x = ReadFloat(event.packet, &offset);
+						position.y = ReadFloat(event.packet, &offset);
+						position.z = ReadFloat(event.packet, &offset);
+						Players[playerId].Velocity = ReadVelocity(event.packet, &offset);
+
+						// sent before they heard about our last correction, it moved on from where they were, not where we put them.
+						// the position is thrown away, the correction is on its way and the next one starts from it
+						uint8_t respawn = ReadByte(event.packet, &offset);
+						uint8_t correction = ReadByte(event.packet, &offset);
+						if (correction == Players[playerId].CorrectionCount)
+						{
+							// move them from where they were (the spawn we gave them, to start with) with the same sweep the client used,
+							// so nobody walks through walls. a respawn jumps straight to the spawn point instead, anything else
+							// would sweep up from under the map and get stuck on the bottom of the floor
+							Vector3 swept = position;
+							if (respawn == Players[playerId].RespawnCount || !IsSpawnPoint(position))
+							{
+								Vector3 last = { Players[playerId].X, Players[playerId].Y, Players[playerId].Z };
+								swept = SweepBean(&collisionWorld, last, Vector3Subtract(position, last), NULL);
+							}
+							Players[playerId].RespawnCount = respawn;
+
+							Players[playerId].X = swept.x;
+							Players[playerId].Y = swept.y;
+							Players[playerId].Z = swept.z;
+
+							// everyone else sees where our sweep ended, so the client has to be there too or it would carry on
+							// from somewhere nobody else sees it
+							if (Vector3Distance(swept, position) > CORRECTION_TOLERANCE)
+							{
+								Players[playerId].CorrectionCount++;
+								SendCorrection(playerId);
+							}
+						}
+						uint8_t poseParts = ReadPose(event.packet, &offset, &Players[playerId].Pose);
+
+						// it goes out with everyone's next snapshot, at whatever rate their link can take.
+						// only the pose parts they changed get passed on (it's all reliable, so the parts add up)
+						MarkPending(playerId, poseParts | PENDING_MOVED);
+					}
+					else if (command == PlayerAttributes)
+					{
+						// anything older than what we have got here late, drop it
+						uint16_t revision = (uint16_t)ReadShort(event.packet, &offset);
+						if (Players[playerId].HasAttributes && (int16_t)(revision - Players[playerId].AttributesRevision) <= 0)
+						{
+							enet_packet_destroy(event.packet);
+							break;
+						}
+
+						Players[playerId].AttributesRevision = revision;
 						Players[playerId].R = ReadByte(event.packet, &offset);
 						Players[playerId].G = ReadByte(event.packet, &offset);
 						Players[playerId].B = ReadByte(event.packet, &offset);
 						Players[playerId].A = ReadByte(event.packet, &offset);
+						Players[playerId].HasAttributes = true;
 
-						// lets tell everyone about this new location
-						NetworkCommands outboundCommand = UpdatePlayer;
-
-						// if they are new, send this update as an add player instead of an update
-						if (!Players[playerId].ValidPosition)
-							outboundCommand = AddPlayer;
-
-						// the player has sent us a position, they can be part of future regular updates
-						Players[playerId].ValidPosition = true;
-
-						// pack up the update message with command, player and position
-						uint8_t buffer[18] = { 0 };
-						buffer[0] = (uint8_t)outboundCommand;
-						buffer[1] = (uint8_t)playerId;
-						*(float*)(buffer + 2) = (float)Players[playerId].X;
-						*(float*)(buffer + 6) = (float)Players[playerId].Y;
-						*(float*)(buffer + 10) = (float)Players[playerId].Z;
-						*(uint8_t*)(buffer + 14) = (uint8_t)Players[playerId].R;
-						*(uint8_t*)(buffer + 15) = (uint8_t)Players[playerId].G;
-						*(uint8_t*)(buffer + 16) = (uint8_t)Players[playerId].B;
-						*(uint8_t*)(buffer + 17) = (uint8_t)Players[playerId].A;
-
-
-						// Copy and send the data to everyone but the player who sent it  (TODO : add write functions to go directly to a packet)
-						ENetPacket* packet = enet_packet_create(buffer, 18, ENET_PACKET_FLAG_RELIABLE);
-						SendToAllBut(packet, playerId);
-
-						// NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-						// you don't have to destroy them
+						// everyone hears about it next snapshot, even if they haven't been added yet, so the bean shows up the right color
+						MarkPending(playerId, PENDING_ATTRIBUTES);
 					}
 
 					// tell enet that it can recycle the inbound packet
@@ -283,22 +820,21 @@ int main()
 					if (playerId == -1)
 						break;
 
-					// mark them as inactive and clear the peer pointer
-					Players[playerId].Active = false;
-					Players[playerId].Peer = NULL;
-
-					// Tell everyone that someone left
-					uint8_t buffer[2] = { 0 };
-					buffer[0] = (uint8_t)RemovePlayer;
-					buffer[1] = (uint8_t)playerId;
-
-					// Copy and send the data to everyone but the player who sent it  (TODO : add write functions to go directly to a packet)
-					ENetPacket* packet = enet_packet_create(buffer, 2, ENET_PACKET_FLAG_RELIABLE);
-					SendToAllBut(packet, -1);
-
-					// NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-					// you don't have to destroy them
+					// if they quit the slot is free now. if they dropped, hold it (and their bean, standing still) for a while
+					// so they can come back with their token
+					if (event.data == DISCONNECT_QUIT)
+					{
+						ReleasePlayer(playerId);
+						break;
+					}
 
+					Players[playerId].Peer = NULL;
+					Players[playerId].ResumeUntil = now + RESUME_GRACE;
+					if (Players[playerId].ValidPosition)
+					{
+						Players[playerId].Velocity = (Vector3){ 0 };
+						MarkPending(playerId, PENDING_MOVED);
+					}
 					break;
 				}
 
@@ -306,11 +842,18 @@ int main()
 					break;
 			}
 		}
+
+		now = enet_time_get() / 1000.0;
+		ReleaseHeldPlayers(now);
+		SendSnapshots(server, now);
 	}
 
 	// cleanup
 	enet_host_destroy(server);
 	enet_deinitialize();
+	if (RandomSource != NULL)
+		fclose(RandomSource);
+	UnloadLevel(&level);
 
 	return 0;
 }
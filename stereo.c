@@ -0,0 +1,175 @@
+#include "stereo.h"
+#include "raylib/raymath.h"
+#include "raylib/rlgl.h"
+#include "trace.h"
+#include <GLES3/gl3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef GL_CLIP_DISTANCE0_EXT
+#define GL_CLIP_DISTANCE0_EXT 0x3000
+#endif
+
+static const char* stereoVertexPrelude =
+    "uniform mat4 stereoMvp[2];\n"
+    "uniform int stereoEye;\n" // -1 when both eyes are drawn in one pass
+    "out float stereoClip;\n"
+    "vec4 StereoPosition(vec4 position)\n"
+    "{\n"
+    "    if (stereoEye >= 0) {\n"
+    "        stereoClip = 1.0;\n"
+    "        return stereoMvp[stereoEye]*position;\n"
+    "    }\n"
+    "    int eye = gl_InstanceID % 2;\n"
+    "    vec4 clip = stereoMvp[eye]*position;\n"
+    "    clip.x = clip.x*0.5 + (float(eye) - 0.5)*clip.w;\n" // left eye in -1..0, right eye in 0..1
+    "    stereoClip = (eye == 0) ? -clip.x : clip.x;\n"
+    "#ifdef STEREO_CLIP_DISTANCE\n"
+    "    gl_ClipDistance[0] = stereoClip;\n"
+    "#endif\n"
+    "    return clip;\n"
+    "}\n";
+
+static const char* stereoFragmentPrelude =
+    "in float stereoClip;\n"
+    "void StereoClip()\n"
+    "{\n"
+    "#ifndef STEREO_CLIP_DISTANCE\n"
+    "    if (stereoClip < 0.0) discard;\n"
+    "#endif\n"
+    "}\n";
+
+static bool clipDistance = false;
+static bool singlePass = true;
+
+// state for the draw in progress
+static bool passSingle = false;
+static int passEyes = 1;
+static int passWidth = 0;
+static int passHeight = 0;
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension != NULL && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+void InitStereo(void)
+{
+    clipDistance = HasExtension("GL_EXT_clip_cull_distance");
+    TraceLog(LOG_INFO, "STEREO: Single pass %s, clipping with %s", singlePass ? "on" : "off", clipDistance ? "clip distance" : "discard");
+}
+
+void SetStereoSinglePass(bool enabled)
+{
+    singlePass = enabled;
+}
+
+bool IsStereoSinglePass(void)
+{
+    return singlePass;
+}
+
+StereoShader LoadStereoShader(const char* vsCode, const char* fsCode)
+{
+    StereoShader shader = { 0 };
+
+    const char* header = clipDistance ?
+        "#version 300 es\n#extension GL_EXT_clip_cull_distance : require\n#define STEREO_CLIP_DISTANCE\n" :
+        "#version 300 es\n";
+
+    size_t vsLength = strlen(header) + strlen(stereoVertexPrelude) + strlen(vsCode) + 1;
+    size_t fsLength = strlen(header) + strlen("precision mediump float;\n") + strlen(stereoFragmentPrelude) + strlen(fsCode) + 1;
+    char* vs = malloc(vsLength);
+    char* fs = malloc(fsLength);
+    snprintf(vs, vsLength, "%s%s%s", header, stereoVertexPrelude, vsCode);
+    snprintf(fs, fsLength, "%sprecision mediump float;\n%s%s", header, stereoFragmentPrelude, fsCode);
+
+    shader.id = rlLoadShaderCode(vs, fs);
+    free(vs);
+    free(fs);
+
+    // rlgl hands back the default shader when compiling fails
+    if (shader.id == rlGetShaderIdDefault()) shader.id = 0;
+    if (shader.id == 0) return shader;
+
+    shader.mvpLoc = rlGetLocationUniform(shader.id, "stereoMvp");
+    shader.eyeLoc = rlGetLocationUniform(shader.id, "stereoEye");
+    return shader;
+}
+
+void UnloadStereoShader(StereoShader shader)
+{
+    if (shader.id != 0) rlUnloadShaderProgram(shader.id);
+}
+
+int BeginStereoDraw(StereoShader shader)
+{
+    // flush whatever rlgl has queued so it keeps its place in draw order
+    rlDrawRenderBatchActive();
+
+    // same matrices rlDrawRenderBatch uses for each eye
+    Matrix modelview = rlGetMatrixModelview();
+    float mvp[2][16];
+    if (rlIsStereoRenderEnabled()) {
+        passEyes = 2;
+        for (int eye = 0; eye < 2; eye++) {
+            Matrix m = MatrixMultiply(MatrixMultiply(modelview, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+            memcpy(mvp[eye], MatrixToFloatV(m).v, sizeof(mvp[eye]));
+        }
+    } else {
+        passEyes = 1;
+        memcpy(mvp[0], MatrixToFloatV(MatrixMultiply(modelview, rlGetMatrixProjection())).v, sizeof(mvp[0]));
+        memcpy(mvp[1], mvp[0], sizeof(mvp[1]));
+    }
+
+    passSingle = singlePass && passEyes == 2;
+    passWidth = rlGetFramebufferWidth();
+    passHeight = rlGetFramebufferHeight();
+
+    glUseProgram(shader.id);
+    glUniformMatrix4fv(shader.mvpLoc, 2, GL_FALSE, &mvp[0][0]);
+
+    if (passSingle) {
+        glUniform1i(shader.eyeLoc, -1);
+        if (clipDistance) glEnable(GL_CLIP_DISTANCE0_EXT);
+        return 1;
+    }
+    return passEyes;
+}
+
+void SetStereoPass(StereoShader shader, int pass)
+{
+    if (passSingle) return;
+
+    glUniform1i(shader.eyeLoc, pass);
+    if (passEyes == 2) rlViewport(pass * passWidth / 2, 0, passWidth / 2, passHeight);
+}
+
+int StereoInstances(int instances)
+{
+    return passSingle ? instances * 2 : instances;
+}
+
+int StereoInstanceDivisor(void)
+{
+    return passSingle ? 2 : 1;
+}
+
+void EndStereoDraw(void)
+{
+    TRACE_COUNTER("stereo passes", passSingle ? 1 : passEyes);
+
+    if (passSingle) {
+        if (clipDistance) glDisable(GL_CLIP_DISTANCE0_EXT);
+    } else if (passEyes == 2) {
+        rlViewport(0, 0, passWidth, passHeight);
+    }
+    glUseProgram(0);
+}
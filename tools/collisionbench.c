@@ -0,0 +1,108 @@
+// collisionbench, times the collision queries and the bean controller
+//
+//   collisionbench                 random world of 5000 boxes and spheres
+//   collisionbench arena.level     a real level
+//
+// prints queries per millisecond for bvh overlap queries, capsule sweeps and full controller steps
+
+#include "collision.h"
+#include "level.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RANDOM_SHAPES 5000
+#define RANDOM_EXTENT 200.0f
+#define QUERIES 200000
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+static void BuildRandomWorld(CollisionWorld* world)
+{
+    LevelSphere* spheres = malloc(RANDOM_SHAPES / 2 * sizeof(LevelSphere));
+    BoundingBox* boxes = malloc((RANDOM_SHAPES / 2 + 1) * sizeof(BoundingBox));
+
+    for (int i = 0; i < RANDOM_SHAPES / 2; i++) {
+        spheres[i] = (LevelSphere){ { Random(-RANDOM_EXTENT, RANDOM_EXTENT), Random(0.0f, 4.0f), Random(-RANDOM_EXTENT, RANDOM_EXTENT) }, Random(0.2f, 2.0f) };
+        Vector3 center = { Random(-RANDOM_EXTENT, RANDOM_EXTENT), Random(0.0f, 4.0f), Random(-RANDOM_EXTENT, RANDOM_EXTENT) };
+        Vector3 half = { Random(0.1f, 2.0f), Random(0.1f, 2.0f), Random(0.1f, 2.0f) };
+        boxes[i] = (BoundingBox){ { center.x - half.x, center.y - half.y, center.z - half.z }, { center.x + half.x, center.y + half.y, center.z + half.z } };
+    }
+    // and a floor under all of it
+    boxes[RANDOM_SHAPES / 2] = (BoundingBox){ { -RANDOM_EXTENT, 0.0f, -RANDOM_EXTENT }, { RANDOM_EXTENT, 0.0f, RANDOM_EXTENT } };
+
+    BuildCollisionWorld(world, spheres, RANDOM_SHAPES / 2, boxes, RANDOM_SHAPES / 2 + 1);
+    free(spheres);
+    free(boxes);
+}
+
+static void Report(const char* name, uint64_t start, int count)
+{
+    double ms = (double)(TraceNowNs() - start) / 1000000.0;
+    printf("%-10s %8d in %8.2f ms  %10.1f per ms\n", name, count, ms, count / ms);
+}
+
+int main(int argc, char* argv[])
+{
+    Level level = { 0 };
+    CollisionWorld world;
+    float extent = RANDOM_EXTENT;
+
+    if (argc > 1) {
+        if (!LoadLevel(&level, argv[1])) {
+            fprintf(stderr, "collisionbench: can't load %s\n", argv[1]);
+            return 1;
+        }
+        CollisionWorldFromLevel(&world, &level);
+        extent = 16.0f;
+    } else {
+        BuildRandomWorld(&world);
+    }
+    printf("%u spheres, %u boxes, %u bvh nodes\n", world.sphereCount, world.boxCount, world.nodeCount);
+
+    // same positions for every test so they're comparable
+    Vector3* positions = malloc(QUERIES * sizeof(Vector3));
+    Vector3* walks = malloc(QUERIES * sizeof(Vector3));
+    for (int i = 0; i < QUERIES; i++) {
+        positions[i] = (Vector3){ Random(-extent, extent), Random(1.7f, 3.0f), Random(-extent, extent) };
+        walks[i] = (Vector3){ Random(-0.1f, 0.1f), 0.0f, Random(-0.1f, 0.1f) };
+    }
+
+    uint64_t found = 0;
+    uint64_t start = TraceNowNs();
+    for (int i = 0; i < QUERIES; i++) {
+        Vector3 p = positions[i];
+        uint32_t items[64];
+        found += QueryCollisionWorld(&world, (BoundingBox){ { p.x - 0.7f, p.y - 1.7f, p.z - 0.7f }, { p.x + 0.7f, p.y + 0.9f, p.z + 0.7f } }, items, 64);
+    }
+    Report("query", start, QUERIES);
+
+    float sink = 0.0f;
+    start = TraceNowNs();
+    for (int i = 0; i < QUERIES; i++) {
+        sink += SweepBean(&world, positions[i], walks[i], NULL).y;
+    }
+    Report("sweep", start, QUERIES);
+
+    start = TraceNowNs();
+    for (int i = 0; i < QUERIES; i++) {
+        BeanBody body = { 0.0f, true };
+        sink += MoveBean(&world, &body, positions[i], walks[i], 1.0f / 72.0f).y;
+    }
+    Report("move", start, QUERIES);
+
+    // keeps the loops from being optimized away
+    printf("(%llu shapes hit, %f)\n", (unsigned long long)found, sink);
+
+    free(positions);
+    free(walks);
+    if (argc > 1) {
+        UnloadLevel(&level);
+    } else {
+        UnloadCollisionWorld(&world);
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+// levelc, turns a text level description into the binary level format in include/level.h
+//
+//   levelc arena.txt arena.level
+//
+// one thing per line, # starts a comment, colors are 0-255
+//   plane  x y z  width depth  r g b a
+//   cube   x y z  width height depth  r g b a
+//   sphere x y z  radius  r g b a
+//   spawn  x y z  yaw_degrees
+
+#include "level.h"
+#include "collision.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// rings and slices for level spheres, they're baked once so they can afford to be round
+#define SPHERE_RINGS 16
+#define SPHERE_SLICES 16
+
+static LevelSphere* spheres = NULL;
+static uint32_t sphereCount = 0;
+static BoundingBox* boxes = NULL;
+static uint32_t boxCount = 0;
+static LevelSpawn* spawns = NULL;
+static uint32_t spawnCount = 0;
+
+static void* Grow(void* array, uint32_t count, size_t stride)
+{
+    // power of two sizes, so growing when count hits one is enough
+    if (count == 0 || (count & (count - 1)) == 0) {
+        array = realloc(array, (count ? count * 2 : 16) * stride);
+        if (array == NULL) {
+            fprintf(stderr, "levelc: out of memory\n");
+            exit(1);
+        }
+    }
+    return array;
+}
+
+static Color ReadColor(int r, int g, int b, int a)
+{
+    return (Color){ (unsigned char)r, (unsigned char)g, (unsigned char)b, (unsigned char)a };
+}
+
+static void AddBox(Vector3 min, Vector3 max)
+{
+    boxes = Grow(boxes, boxCount, sizeof(BoundingBox));
+    boxes[boxCount++] = (BoundingBox){ min, max };
+}
+
+static bool ReadLevel(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "levelc: can't open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    int lineNumber = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char kind[16];
+        if (sscanf(line, "%15s", kind) != 1) continue;
+
+        float x, y, z, a, b, c;
+        int r, g, bl, al;
+        if (strcmp(kind, "plane") == 0 && sscanf(line, "%*s %f %f %f %f %f %d %d %d %d", &x, &y, &z, &a, &b, &r, &g, &bl, &al) == 9) {
+            AddWorldPlane((Vector3){ x, y, z }, (Vector2){ a, b }, ReadColor(r, g, bl, al));
+            // planes collide as a box with no height
+            AddBox((Vector3){ x - a * 0.5f, y, z - b * 0.5f }, (Vector3){ x + a * 0.5f, y, z + b * 0.5f });
+        } else if (strcmp(kind, "cube") == 0 && sscanf(line, "%*s %f %f %f %f %f %f %d %d %d %d", &x, &y, &z, &a, &b, &c, &r, &g, &bl, &al) == 10) {
+            AddWorldCube((Vector3){ x, y, z }, (Vector3){ a, b, c }, ReadColor(r, g, bl, al));
+            AddBox((Vector3){ x - a * 0.5f, y - b * 0.5f, z - c * 0.5f }, (Vector3){ x + a * 0.5f, y + b * 0.5f, z + c * 0.5f });
+        } else if (strcmp(kind, "sphere") == 0 && sscanf(line, "%*s %f %f %f %f %d %d %d %d", &x, &y, &z, &a, &r, &g, &bl, &al) == 8) {
+            AddWorldSphere((Vector3){ x, y, z }, a, SPHERE_RINGS, SPHERE_SLICES, ReadColor(r, g, bl, al));
+            spheres = Grow(spheres, sphereCount, sizeof(LevelSphere));
+            spheres[sphereCount++] = (LevelSphere){ { x, y, z }, a };
+        } else if (strcmp(kind, "spawn") == 0 && sscanf(line, "%*s %f %f %f %f", &x, &y, &z, &a) == 4) {
+            spawns = Grow(spawns, spawnCount, sizeof(LevelSpawn));
+            spawns[spawnCount++] = (LevelSpawn){ { x, y, z }, a * (float)M_PI / 180.0f };
+        } else {
+            fprintf(stderr, "%s:%d: can't read '%s'\n", path, lineNumber, kind);
+            ok = false;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static uint32_t Align(uint32_t offset)
+{
+    return (offset + LEVEL_ALIGN - 1) & ~(uint32_t)(LEVEL_ALIGN - 1);
+}
+
+static bool WriteLevel(const char* path, const WorldMesh* mesh, const CollisionWorld* collision)
+{
+    const void* data[LEVEL_SECTION_COUNT] = { mesh->vertices, mesh->indices, mesh->ranges, spheres, boxes, spawns, collision->nodes, collision->items };
+    const uint32_t counts[LEVEL_SECTION_COUNT] = { mesh->vertexCount, mesh->indexCount, mesh->rangeCount, sphereCount, boxCount, spawnCount, collision->nodeCount, collision->itemCount };
+    const uint32_t strides[LEVEL_SECTION_COUNT] = { sizeof(Vector3), sizeof(uint32_t), sizeof(WorldRange), sizeof(LevelSphere), sizeof(BoundingBox), sizeof(LevelSpawn), sizeof(LevelBvhNode), sizeof(uint32_t) };
+
+    LevelHeader header = { LEVEL_MAGIC, LEVEL_VERSION, 0, LEVEL_SECTION_COUNT };
+    uint32_t offset = Align(sizeof(LevelHeader));
+    for (int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        header.sections[i] = (LevelSection){ offset, counts[i] * strides[i], counts[i], strides[i] };
+        offset = Align(offset + header.sections[i].size);
+    }
+    header.size = offset;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "levelc: can't write %s\n", path);
+        return false;
+    }
+
+    static const uint8_t padding[LEVEL_ALIGN] = { 0 };
+    fwrite(&header, sizeof(header), 1, file);
+    uint32_t written = sizeof(header);
+    for (int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        fwrite(padding, 1, header.sections[i].offset - written, file);
+        if (header.sections[i].size > 0) fwrite(data[i], header.sections[i].size, 1, file);
+        written = header.sections[i].offset + header.sections[i].size;
+    }
+    fwrite(padding, 1, header.size - written, file);
+
+    return fclose(file) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: levelc input.txt output.level\n");
+        return 1;
+    }
+
+    BeginWorld();
+    if (!ReadLevel(argv[1])) return 1;
+
+    WorldMesh mesh;
+    if (!MergeWorld(&mesh)) {
+        fprintf(stderr, "levelc: out of memory\n");
+        return 1;
+    }
+
+    // the bvh gets built here once so loading the level never has to
+    CollisionWorld collision;
+    if (!BuildCollisionWorld(&collision, spheres, sphereCount, boxes, boxCount)) {
+        fprintf(stderr, "levelc: out of memory\n");
+        return 1;
+    }
+
+    if (!WriteLevel(argv[2], &mesh, &collision)) return 1;
+
+    printf("%s: %u vertices, %u indices, %u materials, %u spheres, %u boxes, %u spawns, %u bvh nodes\n",
+        argv[2], mesh.vertexCount, mesh.indexCount, mesh.rangeCount, sphereCount, boxCount, spawnCount, collision.nodeCount);
+
+    UnloadCollisionWorld(&collision);
+    FreeWorldMesh(&mesh);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "trace.h"
+
+#if BEAN_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+// events per thread, must be a power of two. 64k events is a few seconds of frames
+#define TRACE_RING_SIZE (1 << 16)
+#define TRACE_MAX_THREADS 16
+
+typedef enum {
+    TRACE_EVENT_BEGIN,
+    TRACE_EVENT_END,
+    TRACE_EVENT_COUNTER,
+    TRACE_EVENT_INSTANT
+} TraceEventType;
+
+typedef struct TraceEvent {
+    uint64_t time; // nanoseconds, TraceNowNs
+    const char* name;
+    int64_t value; // counters only
+    uint32_t type;
+} TraceEvent;
+
+// one ring per thread, only that thread writes to it so nothing is locked
+// the head is published with release ordering so a dump from another thread sees whole events
+typedef struct TraceRing {
+    _Atomic uint64_t head;
+    uint32_t tid;
+    TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+static TraceRing* rings[TRACE_MAX_THREADS] = { 0 };
+static _Atomic uint32_t ringCount = 0;
+static _Thread_local TraceRing* localRing = NULL;
+
+static TraceRing* GetRing(void)
+{
+    if (localRing != NULL)
+        return localRing;
+
+    // first event on this thread, grab a slot. threads past the limit just don't get traced
+    uint32_t slot = atomic_fetch_add(&ringCount, 1);
+    if (slot >= TRACE_MAX_THREADS)
+        return NULL;
+
+    TraceRing* ring = calloc(1, sizeof(TraceRing));
+    if (ring == NULL)
+        return NULL;
+
+    ring->tid = slot + 1;
+    rings[slot] = ring;
+    localRing = ring;
+    return ring;
+}
+
+static void Push(uint32_t type, const char* name, int64_t value)
+{
+    TraceRing* ring = GetRing();
+    if (ring == NULL)
+        return;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent* event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->time = TraceNowNs();
+    event->name = name;
+    event->value = value;
+    event->type = type;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void TraceBegin(const char* name) { Push(TRACE_EVENT_BEGIN, name, 0); }
+void TraceEnd(const char* name) { Push(TRACE_EVENT_END, name, 0); }
+void TraceCounter(const char* name, int64_t value) { Push(TRACE_EVENT_COUNTER, name, value); }
+void TraceInstant(const char* name) { Push(TRACE_EVENT_INSTANT, name, 0); }
+
+bool TraceDump(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+
+    // timestamps are written relative to the oldest event so the numbers stay small
+    uint64_t origin = UINT64_MAX;
+    uint32_t count = atomic_load(&ringCount);
+    if (count > TRACE_MAX_THREADS) count = TRACE_MAX_THREADS;
+
+    for (uint32_t i = 0; i < count; i++) {
+        TraceRing* ring = rings[i];
+        if (ring == NULL) continue;
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        if (head > tail && ring->events[tail & (TRACE_RING_SIZE - 1)].time < origin)
+            origin = ring->events[tail & (TRACE_RING_SIZE - 1)].time;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+
+    for (uint32_t i = 0; i < count; i++) {
+        TraceRing* ring = rings[i];
+        if (ring == NULL) continue;
+
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+        // the oldest events may have been overwritten while we read, skip a little slack to be safe
+        if (head - tail == TRACE_RING_SIZE) tail += 64;
+
+        for (uint64_t e = tail; e < head; e++) {
+            const TraceEvent* event = &ring->events[e & (TRACE_RING_SIZE - 1)];
+            double ts = (double)(event->time - origin) / 1000.0; // chrome wants microseconds
+
+            fprintf(file, first ? "" : ",\n");
+            first = false;
+
+            switch (event->type) {
+                case TRACE_EVENT_BEGIN:
+                    fprintf(file, "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", event->name, ts, ring->tid);
+                    break;
+                case TRACE_EVENT_END:
+                    fprintf(file, "{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", event->name, ts, ring->tid);
+                    break;
+                case TRACE_EVENT_COUNTER:
+                    fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}", event->name, ts, ring->tid, (long long)event->value);
+                    break;
+                case TRACE_EVENT_INSTANT:
+                    fprintf(file, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", event->name, ts, ring->tid);
+                    break;
+            }
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "world.h"
+#include "raylib/rlgl.h"
+#include "stereo.h"
+#include "trace.h"
+#include <GLES3/gl3.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the stereo prelude from stereo.c goes in front of these
+static const char* worldVertexShader =
+    "layout(location = 0) in vec3 vertexPosition;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = StereoPosition(vec4(vertexPosition, 1.0));\n"
+    "}\n";
+
+static const char* worldFragmentShader =
+    "uniform vec4 materialColor;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    StereoClip();\n"
+    "    finalColor = materialColor;\n"
+    "}\n";
+
+static bool gpu = false;
+static StereoShader shader = { 0 };
+static int colorLoc = -1;
+static GLuint vao = 0;
+static GLuint vertexBuffer = 0;
+static GLuint indexBuffer = 0;
+
+static WorldRange* ranges = NULL;
+static uint32_t rangeCount = 0;
+
+// kept around only when there's no GLES3 and the world has to go through the rlgl batch
+static Vector3* cpuVertices = NULL;
+static uint32_t* cpuIndices = NULL;
+
+bool BuildWorld(void)
+{
+    WorldMesh mesh;
+    if (!MergeWorld(&mesh)) return false;
+
+    bool ok = LoadWorldBuffers(mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, mesh.ranges, mesh.rangeCount);
+
+    TraceLog(LOG_INFO, "WORLD: Built %u vertices, %u indices in %u materials", mesh.vertexCount, mesh.indexCount, mesh.rangeCount);
+    FreeWorldMesh(&mesh);
+    return ok;
+}
+
+bool LoadWorldBuffers(const Vector3* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const WorldRange* worldRanges, uint32_t worldRangeCount)
+{
+    UnloadWorld();
+
+    ranges = malloc(worldRangeCount * sizeof(WorldRange));
+    memcpy(ranges, worldRanges, worldRangeCount * sizeof(WorldRange));
+    rangeCount = worldRangeCount;
+
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version != NULL && strncmp(version, "OpenGL ES 3", 11) == 0) {
+        shader = LoadStereoShader(worldVertexShader, worldFragmentShader);
+    }
+
+    if (shader.id == 0) {
+        TraceLog(LOG_WARNING, "WORLD: No GLES3 shader, drawing through the rlgl batch");
+        cpuVertices = malloc(vertexCount * sizeof(Vector3));
+        cpuIndices = malloc(indexCount * sizeof(uint32_t));
+        memcpy(cpuVertices, vertices, vertexCount * sizeof(Vector3));
+        memcpy(cpuIndices, indices, indexCount * sizeof(uint32_t));
+        return true;
+    }
+    colorLoc = rlGetLocationUniform(shader.id, "materialColor");
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vector3), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3), (void*)0);
+
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gpu = true;
+    return true;
+}
+
+static void DrawWorldBatched(void)
+{
+    for (uint32_t r = 0; r < rangeCount; r++) {
+        const WorldRange* range = &ranges[r];
+        // rlgl wants whole triangles in one batch, 3 * 1024 is well under its buffer size
+        for (uint32_t start = 0; start < range->indexCount; start += 3 * 1024) {
+            uint32_t end = start + 3 * 1024;
+            if (end > range->indexCount) end = range->indexCount;
+
+            rlCheckRenderBatchLimit(end - start);
+            rlBegin(RL_TRIANGLES);
+            rlColor4ub(range->color.r, range->color.g, range->color.b, range->color.a);
+            for (uint32_t i = range->firstIndex + start; i < range->firstIndex + end; i++) {
+                Vector3 v = cpuVertices[cpuIndices[i]];
+                rlVertex3f(v.x, v.y, v.z);
+            }
+            rlEnd();
+        }
+    }
+}
+
+void DrawWorld(void)
+{
+    if (rangeCount == 0) return;
+
+    TRACE_BEGIN("draw world");
+
+    if (!gpu) {
+        DrawWorldBatched();
+        TRACE_END("draw world");
+        return;
+    }
+
+    int passes = BeginStereoDraw(shader);
+    glBindVertexArray(vao);
+
+    for (int pass = 0; pass < passes; pass++) {
+        SetStereoPass(shader, pass);
+        for (uint32_t r = 0; r < rangeCount; r++) {
+            const WorldRange* range = &ranges[r];
+            glUniform4f(colorLoc, range->color.r / 255.0f, range->color.g / 255.0f, range->color.b / 255.0f, range->color.a / 255.0f);
+            glDrawElementsInstanced(GL_TRIANGLES, range->indexCount, GL_UNSIGNED_INT, (void*)(range->firstIndex * sizeof(uint32_t)), StereoInstances(1));
+        }
+    }
+
+    glBindVertexArray(0);
+    EndStereoDraw();
+
+    TRACE_COUNTER("world draws", passes * rangeCount);
+    TRACE_END("draw world");
+}
+
+void UnloadWorld(void)
+{
+    if (gpu) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        gpu = false;
+    }
+    UnloadStereoShader(shader);
+    shader = (StereoShader){ 0 };
+
+    free(ranges);
+    free(cpuVertices);
+    free(cpuIndices);
+    ranges = NULL;
+    cpuVertices = NULL;
+    cpuIndices = NULL;
+    rangeCount = 0;
+}
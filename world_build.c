@@ -0,0 +1,167 @@
+#include "world.h"
+#include "raylib/raymath.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// geometry for one material while the world is being built
+typedef struct WorldBuilder {
+    Color color;
+    Vector3* vertices;
+    uint32_t vertexCount;
+    uint32_t vertexCapacity;
+    uint32_t* indices;
+    uint32_t indexCount;
+    uint32_t indexCapacity;
+} WorldBuilder;
+
+static WorldBuilder* builders = NULL;
+static int builderCount = 0;
+
+static WorldBuilder* GetBuilder(Color color)
+{
+    for (int i = 0; i < builderCount; i++) {
+        Color c = builders[i].color;
+        if (c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a) return &builders[i];
+    }
+
+    builders = realloc(builders, (builderCount + 1) * sizeof(WorldBuilder));
+    WorldBuilder* builder = &builders[builderCount++];
+    memset(builder, 0, sizeof(WorldBuilder));
+    builder->color = color;
+    return builder;
+}
+
+static uint32_t AddVertex(WorldBuilder* builder, Vector3 v)
+{
+    if (builder->vertexCount == builder->vertexCapacity) {
+        builder->vertexCapacity = builder->vertexCapacity ? builder->vertexCapacity * 2 : 64;
+        builder->vertices = realloc(builder->vertices, builder->vertexCapacity * sizeof(Vector3));
+    }
+    builder->vertices[builder->vertexCount] = v;
+    return builder->vertexCount++;
+}
+
+static void AddTriangle(WorldBuilder* builder, uint32_t a, uint32_t b, uint32_t c)
+{
+    if (builder->indexCount + 3 > builder->indexCapacity) {
+        builder->indexCapacity = builder->indexCapacity ? builder->indexCapacity * 2 : 192;
+        builder->indices = realloc(builder->indices, builder->indexCapacity * sizeof(uint32_t));
+    }
+    builder->indices[builder->indexCount++] = a;
+    builder->indices[builder->indexCount++] = b;
+    builder->indices[builder->indexCount++] = c;
+}
+
+// u cross v has to point out of the face, that keeps the winding counter clockwise from the outside
+static void AddFace(WorldBuilder* builder, Vector3 center, Vector3 u, Vector3 v)
+{
+    uint32_t a = AddVertex(builder, Vector3Subtract(Vector3Subtract(center, u), v));
+    uint32_t b = AddVertex(builder, Vector3Subtract(Vector3Add(center, u), v));
+    uint32_t c = AddVertex(builder, Vector3Add(Vector3Add(center, u), v));
+    uint32_t d = AddVertex(builder, Vector3Add(Vector3Subtract(center, u), v));
+    AddTriangle(builder, a, b, c);
+    AddTriangle(builder, a, c, d);
+}
+
+static void FreeBuilders(void)
+{
+    for (int i = 0; i < builderCount; i++) {
+        free(builders[i].vertices);
+        free(builders[i].indices);
+    }
+    free(builders);
+    builders = NULL;
+    builderCount = 0;
+}
+
+void BeginWorld(void)
+{
+    FreeBuilders();
+}
+
+void AddWorldPlane(Vector3 center, Vector2 size, Color color)
+{
+    AddFace(GetBuilder(color), center, (Vector3){ 0.0f, 0.0f, size.y * 0.5f }, (Vector3){ size.x * 0.5f, 0.0f, 0.0f });
+}
+
+void AddWorldCube(Vector3 center, Vector3 size, Color color)
+{
+    WorldBuilder* builder = GetBuilder(color);
+    Vector3 h = Vector3Scale(size, 0.5f);
+
+    AddFace(builder, (Vector3){ center.x + h.x, center.y, center.z }, (Vector3){ 0, h.y, 0 }, (Vector3){ 0, 0, h.z });
+    AddFace(builder, (Vector3){ center.x - h.x, center.y, center.z }, (Vector3){ 0, 0, h.z }, (Vector3){ 0, h.y, 0 });
+    AddFace(builder, (Vector3){ center.x, center.y + h.y, center.z }, (Vector3){ 0, 0, h.z }, (Vector3){ h.x, 0, 0 });
+    AddFace(builder, (Vector3){ center.x, center.y - h.y, center.z }, (Vector3){ h.x, 0, 0 }, (Vector3){ 0, 0, h.z });
+    AddFace(builder, (Vector3){ center.x, center.y, center.z + h.z }, (Vector3){ h.x, 0, 0 }, (Vector3){ 0, h.y, 0 });
+    AddFace(builder, (Vector3){ center.x, center.y, center.z - h.z }, (Vector3){ 0, h.y, 0 }, (Vector3){ h.x, 0, 0 });
+}
+
+void AddWorldSphere(Vector3 center, float radius, int rings, int slices, Color color)
+{
+    WorldBuilder* builder = GetBuilder(color);
+    uint32_t base = builder->vertexCount;
+
+    // pole to pole, theta going round counter clockwise when seen from outside
+    for (int row = 0; row <= rings; row++) {
+        float phi = PI / 2.0f - row * PI / rings;
+        for (int col = 0; col <= slices; col++) {
+            float theta = col * 2.0f * PI / slices;
+            AddVertex(builder, (Vector3){
+                center.x + cosf(phi) * sinf(theta) * radius,
+                center.y + sinf(phi) * radius,
+                center.z + cosf(phi) * cosf(theta) * radius
+            });
+        }
+    }
+
+    for (int row = 0; row < rings; row++) {
+        for (int col = 0; col < slices; col++) {
+            uint32_t a = base + row * (slices + 1) + col;
+            uint32_t b = a + slices + 1;
+            AddTriangle(builder, a, b, a + 1);
+            AddTriangle(builder, a + 1, b, b + 1);
+        }
+    }
+}
+
+bool MergeWorld(WorldMesh* mesh)
+{
+    memset(mesh, 0, sizeof(WorldMesh));
+    for (int i = 0; i < builderCount; i++) {
+        mesh->vertexCount += builders[i].vertexCount;
+        mesh->indexCount += builders[i].indexCount;
+    }
+
+    // one material after another, indices rebased onto the merged vertex buffer
+    mesh->vertices = malloc(mesh->vertexCount * sizeof(Vector3) + 1);
+    mesh->indices = malloc(mesh->indexCount * sizeof(uint32_t) + 1);
+    mesh->ranges = malloc(builderCount * sizeof(WorldRange) + 1);
+    if (mesh->vertices == NULL || mesh->indices == NULL || mesh->ranges == NULL) {
+        FreeWorldMesh(mesh);
+        FreeBuilders();
+        return false;
+    }
+
+    uint32_t v = 0;
+    uint32_t n = 0;
+    for (int i = 0; i < builderCount; i++) {
+        memcpy(mesh->vertices + v, builders[i].vertices, builders[i].vertexCount * sizeof(Vector3));
+        mesh->ranges[i] = (WorldRange){ n, builders[i].indexCount, builders[i].color };
+        for (uint32_t j = 0; j < builders[i].indexCount; j++) mesh->indices[n++] = builders[i].indices[j] + v;
+        v += builders[i].vertexCount;
+    }
+    mesh->rangeCount = builderCount;
+
+    FreeBuilders();
+    return true;
+}
+
+void FreeWorldMesh(WorldMesh* mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh->ranges);
+    memset(mesh, 0, sizeof(WorldMesh));
+}
@@ -0,0 +1,129 @@
+#include <EGL/egl.h>
+#include <jni.h>
+#include <string.h>
+#include <math.h>
+
+#include "xr_input.h"
+#include "raylib/raymath.h"
+
+// same as the gamepad ones in player.c
+#define XR_STICK_DEADZONE 0.25f
+#define XR_TURN_SPEED 1.8f
+
+static float GetFloat(tsoContext* ctx, XrAction action, XrPath hand, bool* active)
+{
+    XrActionStateGetInfo gi = { XR_TYPE_ACTION_STATE_GET_INFO };
+    gi.action = action;
+    gi.subactionPath = hand;
+    XrActionStateFloat state = { XR_TYPE_ACTION_STATE_FLOAT };
+    if (tsoCheck(ctx, xrGetActionStateFloat(ctx->tsoSession, &gi, &state), "xrGetActionStateFloat") || !state.isActive) return 0.0f;
+    *active = true;
+    return state.currentState;
+}
+
+static bool GetBoolean(tsoContext* ctx, XrAction action, XrPath hand, bool* active)
+{
+    XrActionStateGetInfo gi = { XR_TYPE_ACTION_STATE_GET_INFO };
+    gi.action = action;
+    gi.subactionPath = hand;
+    XrActionStateBoolean state = { XR_TYPE_ACTION_STATE_BOOLEAN };
+    if (tsoCheck(ctx, xrGetActionStateBoolean(ctx->tsoSession, &gi, &state), "xrGetActionStateBoolean") || !state.isActive) return false;
+    *active = true;
+    return state.currentState;
+}
+
+static Vector2 GetVector2(tsoContext* ctx, XrAction action, XrPath hand, bool* active, XrTime* changeTime)
+{
+    XrActionStateGetInfo gi = { XR_TYPE_ACTION_STATE_GET_INFO };
+    gi.action = action;
+    gi.subactionPath = hand;
+    XrActionStateVector2f state = { XR_TYPE_ACTION_STATE_VECTOR2F };
+    if (tsoCheck(ctx, xrGetActionStateVector2f(ctx->tsoSession, &gi, &state), "xrGetActionStateVector2f") || !state.isActive) return (Vector2){ 0.0f, 0.0f };
+    *active = true;
+    *changeTime = state.lastChangeTime;
+    return (Vector2){ state.currentState.x, state.currentState.y };
+}
+
+static void LocateHand(tsoContext* ctx, int i, XrHandInput* hand, XrTime displayTime)
+{
+    // the pose action only has a space when it's bound, asking first saves locating nothing
+    XrActionStateGetInfo gi = { XR_TYPE_ACTION_STATE_GET_INFO };
+    gi.action = ctx->poseAction;
+    gi.subactionPath = ctx->handPath[i];
+    XrActionStatePose state = { XR_TYPE_ACTION_STATE_POSE };
+    if (tsoCheck(ctx, xrGetActionStatePose(ctx->tsoSession, &gi, &state), "xrGetActionStatePose") || !state.isActive) return;
+    hand->active = true;
+
+    XrSpaceVelocity velocity = { XR_TYPE_SPACE_VELOCITY };
+    XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
+    location.next = &velocity;
+    if (tsoCheck(ctx, xrLocateSpace(ctx->tsoHandSpace[i], ctx->tsoStageSpace, displayTime, &location), "xrLocateSpace [hand]")) return;
+
+    const XrPosef* pose = &location.pose;
+    hand->positionValid = (location.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0;
+    hand->orientationValid = (location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0;
+    if (hand->positionValid) hand->position = (Vector3){ pose->position.x, pose->position.y, pose->position.z };
+    if (hand->orientationValid) hand->orientation = (Quaternion){ pose->orientation.x, pose->orientation.y, pose->orientation.z, pose->orientation.w };
+    if (velocity.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) {
+        hand->linearVelocity = (Vector3){ velocity.linearVelocity.x, velocity.linearVelocity.y, velocity.linearVelocity.z };
+    }
+    if (velocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) {
+        hand->angularVelocity = (Vector3){ velocity.angularVelocity.x, velocity.angularVelocity.y, velocity.angularVelocity.z };
+    }
+}
+
+int SampleXrInput(tsoContext* ctx, XrInput* input, XrTime displayTime)
+{
+    memset(input, 0, sizeof(XrInput));
+    input->displayTime = displayTime;
+    input->sampleTime = GetTime();
+
+    for (int i = 0; i < 2; i++) {
+        XrHandInput* hand = &input->hands[i];
+        XrPath path = ctx->handPath[i];
+        hand->grip = GetFloat(ctx, ctx->grabAction, path, &hand->active);
+        hand->trigger = GetFloat(ctx, ctx->triggerAction, path, &hand->active);
+        hand->triggerClick = GetBoolean(ctx, ctx->triggerActionClick, path, &hand->active);
+        hand->menu = GetBoolean(ctx, ctx->menuAction, path, &hand->active);
+        hand->thumbstick = GetVector2(ctx, ctx->thumbstickAction, path, &hand->active, &hand->thumbstickChangeTime);
+        LocateHand(ctx, i, hand, displayTime);
+    }
+
+    XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
+    if (!tsoCheck(ctx, xrLocateSpace(ctx->tsoViewSpace, ctx->tsoStageSpace, displayTime, &location), "xrLocateSpace [head]")) {
+        const XrPosef* pose = &location.pose;
+        input->headValid = (location.locationFlags & (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT)) ==
+            (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT);
+        input->headPosition = (Vector3){ pose->position.x, pose->position.y, pose->position.z };
+        input->headOrientation = (Quaternion){ pose->orientation.x, pose->orientation.y, pose->orientation.z, pose->orientation.w };
+    }
+    return 0;
+}
+
+void GatherXrIntent(const XrInput* input, BeanIntent* intent, float dt)
+{
+    // the head does the looking up and down, so only yaw comes off the right stick
+    float turn = input->hands[1].thumbstick.x;
+    if (fabsf(turn) > XR_STICK_DEADZONE) intent->yaw -= turn*XR_TURN_SPEED*dt;
+
+    Vector2 move = input->hands[0].thumbstick;
+    if (Vector2Length(move) > XR_STICK_DEADZONE) {
+        intent->move = Vector2Add(intent->move, move);
+        if (Vector2Length(intent->move) > 1.0f) intent->move = Vector2Normalize(intent->move);
+    }
+}
+
+void GetXrPose(const XrInput* input, PlayerPose* pose)
+{
+    // the stage is the bean's frame already, it just has to be moved so the head is the origin
+    pose->head = input->headValid ? input->headOrientation : QuaternionIdentity();
+    pose->tracked = 0;
+    for (int i = 0; i < 2; i++) {
+        const XrHandInput* hand = &input->hands[i];
+        if (!input->headValid || !hand->positionValid || !hand->orientationValid) continue;
+
+        pose->handPosition[i] = Vector3Subtract(hand->position, input->headPosition);
+        pose->handRotation[i] = hand->orientation;
+        pose->tracked |= POSE_LEFT << i;
+    }
+}